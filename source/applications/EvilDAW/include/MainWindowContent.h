@@ -66,7 +66,40 @@ public:
         _menuBarComponent.reset(new juce::MenuBarComponent(this));
         addAndMakeVisible(_menuBarComponent.get());
 
-        _audioProcessor.reset(new ParametricEqualiserProcessor());
+        // Setup the application properties storage.
+        juce::PropertiesFile::Options options;
+        options.applicationName = "equalizer";
+        options.folderName = "EvilAudio";
+        options.filenameSuffix = "settings";
+        options.osxLibrarySubFolder = "Application Support";
+        _applicationProperties.setStorageParameters(options);
+
+        auto userSettings = _applicationProperties.getUserSettings();
+
+        // Read the saved audio processor state first, the processor is created with as many
+        // bands as it holds. The state blob is stored as base64; settings written by earlier
+        // versions hold it as XML text instead, which the processor still understands.
+        auto processorState = juce::MemoryBlock();
+        if (userSettings != nullptr)
+        {
+            auto equalizerSettings = userSettings->getValue("AudioProcessorState");
+            if (equalizerSettings.trimStart().startsWithChar('<'))
+            {
+                if (const auto xmlState = juce::XmlDocument::parse(equalizerSettings))
+                    juce::AudioProcessor::copyXmlToBinary(*xmlState, processorState);
+            }
+            else
+            {
+                processorState.fromBase64Encoding(equalizerSettings);
+            }
+        }
+
+        auto numBands = ParametricEqualiserProcessor::defaultNumBands;
+        if (processorState.getSize() != 0)
+            numBands = ParametricEqualiserProcessor::getNumBandsFromState(processorState.getData(),
+                                                                          static_cast<int>(processorState.getSize()));
+
+        _audioProcessor.reset(new ParametricEqualiserProcessor(numBands));
         _parametricEqualizerEditor.reset(_audioProcessor->createEditorIfNeeded());
         addAndMakeVisible(_parametricEqualizerEditor.get());
 
@@ -78,15 +111,6 @@ public:
         _audioProcessorPlayer->setProcessor(_audioProcessor.get());
         _audioDeviceManager->addAudioCallback(_audioProcessorPlayer.get());
 
-        // Setup the application properties storage.
-        juce::PropertiesFile::Options options;
-        options.applicationName = "equalizer";
-        options.folderName = "EvilAudio";
-        options.filenameSuffix = "settings";
-        options.osxLibrarySubFolder = "Application Support";
-        _applicationProperties.setStorageParameters(options);
-
-        auto userSettings = _applicationProperties.getUserSettings();
         if (userSettings != nullptr)
         {
             // Load the audio device settings from user settings.
@@ -124,19 +148,9 @@ public:
             }
 
             // Load the audio processor state using the processors setStateInformation() method.
-            auto equalizerSettings = userSettings->getValue("AudioProcessorState");
-            {
-                const auto& xmlState = juce::XmlDocument::parse(equalizerSettings);
-                if (xmlState != nullptr)
-                {
-                    auto memoryBlock = juce::MemoryBlock();
-                    {
-                        _audioProcessor->copyXmlToBinary(*xmlState, memoryBlock);
-                        _audioProcessor->setStateInformation(memoryBlock.getData(),
-                                                                static_cast<int>(memoryBlock.getSize()));
-                    }
-                }
-            }
+            if (processorState.getSize() != 0)
+                _audioProcessor->setStateInformation(processorState.getData(),
+                                                     static_cast<int>(processorState.getSize()));
         }
 
         setWantsKeyboardFocus(true);
@@ -168,8 +182,7 @@ public:
                 _audioProcessor->getStateInformation(memoryBlock);
                 if (memoryBlock.getSize() != 0)
                 {
-                    auto xmlElement = _audioProcessor->getXmlFromBinary(static_cast<const char*>(memoryBlock.getData()), size_t(memoryBlock.getSize()));
-                    userSettings->setValue("AudioProcessorState", xmlElement->toString());
+                    userSettings->setValue("AudioProcessorState", memoryBlock.toBase64Encoding());
                 }
             }
             userSettings->saveIfNeeded();
@@ -2,12 +2,6 @@
 #include <JuceHeader.h>
 #include <juce_audio_plugin_client/Standalone/juce_StandaloneFilterWindow.h>
 
-// This creates new instances of the plugin..
-juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
-{
-    return new ParametricEqualiserProcessor();
-}
-
 class EvilEQApplication final : public juce::JUCEApplication
 {
     public:
@@ -90,12 +84,35 @@ class EvilEQApplication final : public juce::JUCEApplication
             );
         }
 
+        /**
+         *  Returns the band count of the state the standalone window restores after creating
+         *  the processor, which it keeps as base64 in the "filterState" user setting.
+         */
+        size_t getSavedNumBands()
+        {
+            juce::MemoryBlock state;
+            if (auto* settings = _appProperties.getUserSettings())
+                state.fromBase64Encoding(settings->getValue("filterState"));
+
+            if (state.isEmpty())
+                return ParametricEqualiserProcessor::defaultNumBands;
+            return ParametricEqualiserProcessor::getNumBandsFromState(state.getData(), static_cast<int>(state.getSize()));
+        }
+
     private:
       std::shared_ptr<juce::DocumentWindow> _mainWindow;
       juce::ApplicationProperties _appProperties;
 
 };
 
+// This creates new instances of the plugin, with as many bands as the saved state holds.
+juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
+{
+    if (auto* application = dynamic_cast<EvilEQApplication*>(juce::JUCEApplication::getInstance()))
+        return new ParametricEqualiserProcessor(application->getSavedNumBands());
+    return new ParametricEqualiserProcessor();
+}
+
 // This macro generates the main() routine that launches the app.
 START_JUCE_APPLICATION(EvilEQApplication)
 
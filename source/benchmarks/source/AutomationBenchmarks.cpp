@@ -0,0 +1,92 @@
+#include "Benchmark.h"
+
+namespace
+{
+    /** The band fields the string dispatch wrote, standing in for the bands of the processor. */
+    struct BandFields
+    {
+        int type = 0;
+        float frequency = 0.0f, quality = 0.0f, gain = 0.0f;
+        bool active = false;
+    };
+
+    /**
+     *  The dispatch parameterChanged() did before the parameter table, by comparing the
+     *  parameter ID with the output ID, the band prefixes and the field suffixes.
+     */
+    void dispatchByString(ParametricEqualiserProcessor& processor, std::vector<BandFields>& bands, float& output,
+                          const juce::String& parameter, float newValue)
+    {
+        if (parameter == ParametricEqualiserProcessor::paramOutput) {
+            output = newValue;
+            return;
+        }
+        const auto index = processor.getBandIndexFromID(parameter);
+        if (juce::isPositiveAndBelow(index, bands.size())) {
+            auto& band = bands[size_t(index)];
+            if (parameter.endsWith(ParametricEqualiserProcessor::paramType))
+                band.type = int(newValue);
+            else if (parameter.endsWith(ParametricEqualiserProcessor::paramFrequency))
+                band.frequency = newValue;
+            else if (parameter.endsWith(ParametricEqualiserProcessor::paramQuality))
+                band.quality = newValue;
+            else if (parameter.endsWith(ParametricEqualiserProcessor::paramGain))
+                band.gain = newValue;
+            else if (parameter.endsWith(ParametricEqualiserProcessor::paramActive))
+                band.active = newValue >= 0.5f;
+        }
+    }
+}
+
+static Benchmark automationBenchmark("Automation dispatch", []
+{
+    constexpr int numChanges = 4096;
+
+    for (auto numBands : { ParametricEqualiserProcessor::defaultNumBands, ParametricEqualiserProcessor::maxNumBands })
+    {
+        ParametricEqualiserProcessor processor(numBands);
+
+        juce::Array<juce::AudioProcessorParameter*> parameters;
+        juce::StringArray parameterIDs;
+        for (auto* parameter : processor.getParameters())
+        {
+            if (auto* withID = dynamic_cast<juce::AudioProcessorParameterWithID*>(parameter))
+            {
+                // The latency parameters re-prepare the processor, which is not dispatch.
+                if (ParametricEqualiserProcessor::isLatencyParameter(withID->paramID))
+                    continue;
+                parameters.add(parameter);
+                parameterIDs.add(withID->paramID);
+            }
+        }
+
+        std::vector<BandFields> bands(numBands);
+        auto output = 0.0f;
+
+        // Walks over all parameters, as automation of every band would.
+        const auto stringTime = Benchmark::measure([&]
+        {
+            for (auto i = 0; i < numChanges; ++i)
+                dispatchByString(processor, bands, output, parameterIDs[i % parameterIDs.size()], float(i & 1));
+        }) / numChanges;
+
+        const auto tableTime = Benchmark::measure([&]
+        {
+            for (auto i = 0; i < numChanges; ++i)
+                processor.parameterValueChanged(parameters[i % parameters.size()]->getParameterIndex(), float(i & 1));
+        }) / numChanges;
+
+        // What a host pays per change, including the listener calls of JUCE.
+        const auto notifyingTime = Benchmark::measure([&]
+        {
+            for (auto i = 0; i < numChanges; ++i)
+                parameters[i % parameters.size()]->setValueNotifyingHost(float(i & 1));
+        }) / numChanges;
+
+        const auto what = juce::String(numBands) + " bands";
+        Benchmark::report("string dispatch, " + what, 1.0 / stringTime, "changes/s");
+        Benchmark::report("table dispatch,  " + what, 1.0 / tableTime, "changes/s");
+        Benchmark::report("speed-up", stringTime / tableTime, "x");
+        Benchmark::report("setValueNotifyingHost with the table, " + what, 1.0 / notifyingTime, "changes/s");
+    }
+});
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+#include "TestSignals.h"
+
+#include <functional>
+#include <iostream>
+
+/**
+ *  A named benchmark, plus the timer and the output the benchmarks share.
+ *
+ *  Each benchmark file defines static Benchmark objects, which register themselves; main()
+ *  runs the ones whose name contains the filter given on the command line. A benchmark times
+ *  the code it compares with measure() and prints every candidate with report(), so that the
+ *  old and the new way end up on adjacent lines.
+ */
+class Benchmark
+{
+public:
+    Benchmark(const juce::String& nameToUse, std::function<void()> functionToRun)
+        : name(nameToUse),
+          function(std::move(functionToRun))
+    {
+        getAll().add(this);
+    }
+
+    const juce::String name;
+    const std::function<void()> function;
+
+    static juce::Array<Benchmark*>& getAll()
+    {
+        static juce::Array<Benchmark*> benchmarks;
+        return benchmarks;
+    }
+
+    /**
+     *  Returns the seconds a call to a function takes, as the fastest of several rounds.
+     *
+     *  The function is called once to warm up, then repeatedly for at least
+     *  minSecondsPerRound in each round.
+     */
+    template <typename Function>
+    static double measure(Function&& functionToTime, int numRounds = 5, double minSecondsPerRound = 0.05)
+    {
+        functionToTime();
+
+        auto best = std::numeric_limits<double>::max();
+        for (auto round = 0; round < numRounds; ++round)
+        {
+            const auto start = juce::Time::getHighResolutionTicks();
+            juce::int64 numCalls = 0;
+            auto elapsed = 0.0;
+            do
+            {
+                functionToTime();
+                ++numCalls;
+                elapsed = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+            }
+            while (elapsed < minSecondsPerRound);
+
+            best = juce::jmin(best, elapsed / double(numCalls));
+        }
+        return best;
+    }
+
+    /** Prints a result line, such as "cascade, 2 channels: 1.20 ns/sample". */
+    static void report(const juce::String& what, double value, const juce::String& unit)
+    {
+        std::cout << (what + ": " + juce::String(value, 2) + " " + unit) << std::endl;
+    }
+
+    /** Sets a parameter to a plain value by its ID, as the host would. */
+    static void setParameter(juce::AudioProcessor& processor, const juce::String& parameterID, float value)
+    {
+        for (auto* parameter : processor.getParameters())
+        {
+            if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter); ranged != nullptr && ranged->paramID == parameterID)
+            {
+                ranged->setValueNotifyingHost(ranged->convertTo0to1(value));
+                return;
+            }
+        }
+        jassertfalse;
+    }
+
+    /**
+     *  Makes every band of an equaliser an active peak, alternately boosting and cutting by
+     *  6 dB, spread from 40 Hz to 16 kHz, so that all filters run. Waits for the design
+     *  thread to pick the settings up.
+     */
+    static void setAllBandsToPeaks(ParametricEqualiserProcessor& processor)
+    {
+        const auto numBands = processor.getNumBands();
+        for (size_t i = 0; i < numBands; ++i)
+        {
+            const auto position = numBands > 1 ? float(i) / float(numBands - 1) : 0.5f;
+            setParameter(processor, ParametricEqualiserProcessor::getTypeParamName(i), float(ParametricEqualiserProcessor::Peak));
+            setParameter(processor, ParametricEqualiserProcessor::getFrequencyParamName(i), 40.0f * std::pow(400.0f, position));
+            setParameter(processor, ParametricEqualiserProcessor::getQualityParamName(i), 1.0f);
+            setParameter(processor, ParametricEqualiserProcessor::getGainParamName(i), i % 2 == 0 ? 2.0f : 0.5f);
+            setParameter(processor, ParametricEqualiserProcessor::getActiveParamName(i), 1.0f);
+        }
+        juce::Thread::sleep(100);
+    }
+
+    /**
+     *  Returns the seconds a processBlock() call takes on a prepared processor. Each call
+     *  filters the same noise again, so that boosts do not build up over the calls.
+     */
+    template <typename SampleType>
+    static double measureProcessBlock(juce::AudioProcessor& processor, int numChannels, int blockSize)
+    {
+        juce::AudioBuffer<SampleType> input(numChannels, blockSize), buffer(numChannels, blockSize);
+        juce::MidiBuffer midi;
+        juce::Random random(1);
+        TestSignals::fillWithNoise(input, random);
+
+        return measure([&]
+        {
+            for (auto channel = 0; channel < numChannels; ++channel)
+                buffer.copyFrom(channel, 0, input, channel, 0, blockSize);
+            processor.processBlock(buffer, midi);
+        });
+    }
+};
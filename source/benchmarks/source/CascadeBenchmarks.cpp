@@ -0,0 +1,82 @@
+#include "Benchmark.h"
+
+namespace
+{
+    // The filter chain the processor used before BiquadCascade: a duplicated IIR filter per band.
+    using FilterBand = juce::dsp::ProcessorDuplicator<juce::dsp::IIR::Filter<float>, juce::dsp::IIR::Coefficients<float>>;
+    using FilterChain = juce::dsp::ProcessorChain<FilterBand, FilterBand, FilterBand, FilterBand, FilterBand, FilterBand>;
+
+    constexpr double sampleRate = 48000.0;
+    constexpr size_t numBands = 6;
+
+    /** Six peaks spread over the spectrum, alternately boosting and cutting by 6 dB. */
+    BiquadCoefficients makeBand(size_t index)
+    {
+        const auto frequency = 60.0 * std::pow(3.0, double(index));
+        const auto gain = index % 2 == 0 ? 2.0 : 0.5;
+        return BilinearBiquadDesign::makePeakFilter(sampleRate, frequency, 1.0, gain);
+    }
+
+    template <size_t... Index>
+    void setCoefficients(FilterChain& chain, std::index_sequence<Index...>)
+    {
+        auto set = [](FilterBand& band, const BiquadCoefficients& c)
+        {
+            *band.state = juce::dsp::IIR::Coefficients<float>(float(c.b0), float(c.b1), float(c.b2), 1.0f, float(c.a1), float(c.a2));
+        };
+        (set(chain.template get<Index>(), makeBand(Index)), ...);
+    }
+}
+
+static Benchmark cascadeBenchmark("Biquad cascade vs ProcessorChain", []
+{
+    for (auto numChannels : { 1, 2, 6, 8 })
+    {
+        for (auto blockSize : { 64, 512 })
+        {
+            const juce::dsp::ProcessSpec spec { sampleRate, juce::uint32(blockSize), juce::uint32(numChannels) };
+
+            juce::AudioBuffer<float> input(numChannels, blockSize), buffer(numChannels, blockSize);
+            juce::Random random(1);
+            TestSignals::fillWithNoise(input, random);
+
+            // Each call filters fresh input, so that the boosts do not build up over the calls.
+            auto timePerSample = [&](auto&& process)
+            {
+                const auto seconds = Benchmark::measure([&]
+                {
+                    for (auto channel = 0; channel < numChannels; ++channel)
+                        buffer.copyFrom(channel, 0, input, channel, 0, blockSize);
+
+                    juce::dsp::AudioBlock<float> block(buffer);
+                    process(juce::dsp::ProcessContextReplacing<float>(block));
+                });
+                return 1.0e9 * seconds / double(blockSize * numChannels);
+            };
+
+            FilterChain chain;
+            chain.prepare(spec);
+            setCoefficients(chain, std::make_index_sequence<numBands>());
+
+            BiquadCascadeSettings settings;
+            for (size_t i = 0; i < numBands; ++i)
+            {
+                settings.sections[i] = makeBand(i);
+                settings.enabled[i] = true;
+            }
+            BiquadCascade<float> cascade;
+            cascade.prepare(spec);
+            cascade.setSettings(settings);
+            cascade.reset();
+
+            const auto chainTime = timePerSample([&](const auto& context) { chain.process(context); });
+            const auto cascadeTime = timePerSample([&](const auto& context) { cascade.process(context); });
+
+            const auto what = juce::String(numBands) + " bands, " + juce::String(numChannels) + " channels, "
+                            + juce::String(blockSize) + " samples";
+            Benchmark::report("ProcessorChain, " + what, chainTime, "ns/sample");
+            Benchmark::report("BiquadCascade,  " + what, cascadeTime, "ns/sample");
+            Benchmark::report("speed-up", chainTime / cascadeTime, "x");
+        }
+    }
+});
@@ -0,0 +1,132 @@
+#include "Benchmark.h"
+
+#include <ctime>
+
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int numChannels = 2;
+    constexpr double secondsPerRun = 2.0;
+
+    /** Decaying noise, the shape of a reverb impulse response. */
+    juce::AudioBuffer<float> makeImpulseResponse(int length)
+    {
+        juce::AudioBuffer<float> impulse(1, length);
+        juce::Random random(2);
+        auto* samples = impulse.getWritePointer(0);
+        for (auto i = 0; i < length; ++i)
+            samples[i] = (2.0f * random.nextFloat() - 1.0f) * std::exp(-6.0f * float(i) / float(length));
+        return impulse;
+    }
+
+    struct Times
+    {
+        double audioThread = 0.0;
+        double allThreads = 0.0;
+    };
+
+    /**
+     *  Feeds secondsPerRun of noise through a convolver, one block at a time and no faster than
+     *  real time, so that the background thread of PartitionedConvolver gets its usual slack
+     *  instead of dropping tail blocks. Returns the seconds per block spent in process() and
+     *  the CPU seconds per block of the whole process, which includes the background thread.
+     */
+    template <typename Process>
+    Times runInRealTime(int blockSize, Process&& process)
+    {
+        juce::AudioBuffer<float> input(numChannels, blockSize), buffer(numChannels, blockSize);
+        juce::Random random(1);
+        TestSignals::fillWithNoise(input, random);
+
+        const auto numBlocks = int(secondsPerRun * sampleRate) / blockSize;
+        const auto blockMilliseconds = 1000.0 * blockSize / sampleRate;
+        const auto start = juce::Time::getMillisecondCounterHiRes();
+        const auto startClock = std::clock();
+        juce::int64 processTicks = 0;
+
+        for (auto block = 0; block < numBlocks; ++block)
+        {
+            for (auto channel = 0; channel < numChannels; ++channel)
+                buffer.copyFrom(channel, 0, input, channel, 0, blockSize);
+
+            const auto ticks = juce::Time::getHighResolutionTicks();
+            juce::dsp::AudioBlock<float> audioBlock(buffer);
+            process(juce::dsp::ProcessContextReplacing<float>(audioBlock));
+            processTicks += juce::Time::getHighResolutionTicks() - ticks;
+
+            const auto ahead = start + (block + 1) * blockMilliseconds - juce::Time::getMillisecondCounterHiRes();
+            if (ahead > 2.0)
+                juce::Thread::sleep(int(ahead));
+        }
+
+        Times times;
+        times.audioThread = juce::Time::highResolutionTicksToSeconds(processTicks) / numBlocks;
+        times.allThreads = double(std::clock() - startClock) / CLOCKS_PER_SEC / numBlocks;
+        return times;
+    }
+
+    void report(const juce::String& what, const Times& times, int blockSize)
+    {
+        Benchmark::report(what + ", audio thread", 1.0e9 * times.audioThread / blockSize, "ns/sample");
+        Benchmark::report(what + ", all threads", 1.0e9 * times.allThreads / blockSize, "ns/sample");
+    }
+
+    /** Loads the impulse into a juce::dsp::Convolution and waits until it has swapped it in. */
+    void load(juce::dsp::Convolution& convolution, const juce::AudioBuffer<float>& impulse, int blockSize)
+    {
+        convolution.loadImpulseResponse(juce::AudioBuffer<float>(impulse), sampleRate,
+                                        juce::dsp::Convolution::Stereo::no,
+                                        juce::dsp::Convolution::Trim::no,
+                                        juce::dsp::Convolution::Normalise::no);
+
+        // The engine is built on a background thread and installed, with a crossfade, by process().
+        juce::AudioBuffer<float> silence(numChannels, blockSize);
+        silence.clear();
+        juce::dsp::AudioBlock<float> block(silence);
+        while (convolution.getCurrentIRSize() != impulse.getNumSamples())
+        {
+            convolution.process(juce::dsp::ProcessContextReplacing<float>(block));
+            juce::Thread::sleep(1);
+        }
+        for (auto i = 0; i < int(sampleRate) / blockSize; ++i)
+            convolution.process(juce::dsp::ProcessContextReplacing<float>(block));
+    }
+}
+
+static Benchmark convolutionBenchmark("PartitionedConvolver vs juce::dsp::Convolution", []
+{
+    for (auto length : { 16384, 65536, 262144 })
+    {
+        const auto impulse = makeImpulseResponse(length);
+
+        for (auto blockSize : { 64, 512 })
+        {
+            const juce::dsp::ProcessSpec spec { sampleRate, juce::uint32(blockSize), juce::uint32(numChannels) };
+            const auto what = juce::String(length) + " taps, " + juce::String(blockSize) + " samples";
+
+            PartitionedConvolver partitioned;
+            partitioned.prepare(spec, size_t(length));
+            partitioned.loadImpulseResponse(impulse.getReadPointer(0), size_t(length));
+            const auto partitionedTimes = runInRealTime(blockSize, [&](const auto& context) { partitioned.process(context); });
+            report("PartitionedConvolver, " + what, partitionedTimes, blockSize);
+            Benchmark::report("PartitionedConvolver tail underruns", partitioned.getNumUnderruns(), "blocks");
+
+            // Zero latency as well: uniform partitions of the block size.
+            juce::dsp::Convolution uniform;
+            uniform.prepare(spec);
+            load(uniform, impulse, blockSize);
+            const auto uniformTimes = runInRealTime(blockSize, [&](const auto& context) { uniform.process(context); });
+            report("juce::dsp::Convolution, " + what, uniformTimes, blockSize);
+
+            // JUCE's own head and tail split, with the same head size.
+            juce::dsp::Convolution nonUniform { juce::dsp::Convolution::NonUniform { int(PartitionedConvolver::headSize) } };
+            nonUniform.prepare(spec);
+            load(nonUniform, impulse, blockSize);
+            const auto nonUniformTimes = runInRealTime(blockSize, [&](const auto& context) { nonUniform.process(context); });
+            report("juce::dsp::Convolution NonUniform, " + what, nonUniformTimes, blockSize);
+
+            Benchmark::report("speed-up over uniform, audio thread", uniformTimes.audioThread / partitionedTimes.audioThread, "x");
+            Benchmark::report("speed-up over NonUniform, audio thread", nonUniformTimes.audioThread / partitionedTimes.audioThread, "x");
+        }
+    }
+});
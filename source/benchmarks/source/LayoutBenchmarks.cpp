@@ -0,0 +1,71 @@
+#include "Benchmark.h"
+
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 512;
+    constexpr size_t numBands = 6;
+
+    /** Six peaks, all stereo or routed to every side there is, left, right, mid and side. */
+    BiquadCascadeSettings makeSettings(bool routed)
+    {
+        static constexpr BiquadCascadeSettings::Routing routings[numBands] = {
+            BiquadCascadeSettings::Stereo, BiquadCascadeSettings::Left, BiquadCascadeSettings::Right,
+            BiquadCascadeSettings::Mid, BiquadCascadeSettings::Side, BiquadCascadeSettings::Stereo
+        };
+
+        BiquadCascadeSettings settings;
+        for (size_t i = 0; i < numBands; ++i)
+        {
+            const auto frequency = 60.0 * std::pow(3.0, double(i));
+            settings.sections[i] = BilinearBiquadDesign::makePeakFilter(sampleRate, frequency, 1.0, i % 2 == 0 ? 2.0 : 0.5);
+            settings.enabled[i] = true;
+            settings.routing[i] = routed ? routings[i] : BiquadCascadeSettings::Stereo;
+        }
+        return settings;
+    }
+}
+
+static Benchmark layoutBenchmark("Biquad cascade per channel layout", []
+{
+    const std::pair<const char*, juce::AudioChannelSet> layouts[] = {
+        { "mono",        juce::AudioChannelSet::mono() },
+        { "stereo",      juce::AudioChannelSet::stereo() },
+        { "5.1",         juce::AudioChannelSet::create5point1() },
+        { "7.1.4",       juce::AudioChannelSet::create7point1point4() },
+        { "ambisonic 3", juce::AudioChannelSet::ambisonic(3) },
+        { "16 discrete", juce::AudioChannelSet::discreteChannels(16) }
+    };
+
+    for (const auto& [name, layout] : layouts)
+    {
+        const auto numChannels = layout.size();
+        const juce::dsp::ProcessSpec spec { sampleRate, juce::uint32(blockSize), juce::uint32(numChannels) };
+
+        juce::AudioBuffer<float> input(numChannels, blockSize), buffer(numChannels, blockSize);
+        juce::Random random(1);
+        TestSignals::fillWithNoise(input, random);
+
+        // Routed bands add the mid/side pass on the pairs, and spread over the unpaired channels.
+        for (auto routed : { false, true })
+        {
+            BiquadCascade<float> cascade;
+            cascade.prepare(spec, layout);
+            cascade.setSettings(makeSettings(routed));
+            cascade.reset();
+
+            const auto seconds = Benchmark::measure([&]
+            {
+                for (auto channel = 0; channel < numChannels; ++channel)
+                    buffer.copyFrom(channel, 0, input, channel, 0, blockSize);
+
+                juce::dsp::AudioBlock<float> block(buffer);
+                cascade.process(juce::dsp::ProcessContextReplacing<float>(block));
+            });
+
+            const auto what = juce::String(name) + ", " + juce::String(numChannels) + " channels, "
+                            + (routed ? "routed bands" : "stereo bands");
+            Benchmark::report(what, 1.0e9 * seconds / double(blockSize * numChannels), "ns/channel sample");
+        }
+    }
+});
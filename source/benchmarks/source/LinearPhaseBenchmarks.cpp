@@ -0,0 +1,35 @@
+#include "Benchmark.h"
+
+static Benchmark linearPhaseBenchmark("Linear phase", []
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int numChannels = 2;
+
+    const auto phaseNames = ParametricEqualiserProcessor::getPhaseNames();
+
+    // Small host buffers are where the partitioned convolution pays the most per sample.
+    for (auto blockSize : { 64, 512 })
+    {
+        auto minimumPhaseTime = 0.0;
+        for (auto phase = 0; phase < phaseNames.size(); ++phase)
+        {
+            // The phase parameter is read when preparing, so it is set first.
+            ParametricEqualiserProcessor processor;
+            Benchmark::setParameter(processor, ParametricEqualiserProcessor::paramPhase, float(phase));
+            processor.prepareToPlay(sampleRate, blockSize);
+            Benchmark::setAllBandsToPeaks(processor);
+
+            const auto time = 1.0e9 * Benchmark::measureProcessBlock<float>(processor, numChannels, blockSize) / blockSize;
+            if (phase == 0)
+                minimumPhaseTime = time;
+
+            const auto what = phaseNames[phase] + ", " + juce::String(blockSize) + " samples, latency "
+                            + juce::String(processor.getLatencySamples());
+            Benchmark::report(what, time, "ns/sample");
+            if (phase > 0)
+                Benchmark::report("cost relative to " + phaseNames[0], time / minimumPhaseTime, "x");
+
+            processor.releaseResources();
+        }
+    }
+});
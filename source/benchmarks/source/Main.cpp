@@ -0,0 +1,22 @@
+#include "Benchmark.h"
+
+/**
+ *  Runs the benchmarks, or only those whose name contains the first command line argument.
+ */
+int main(int argc, char* argv[])
+{
+    // The processors start timers and async updates, which need a message manager.
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    const auto filter = argc > 1 ? juce::String(argv[1]) : juce::String();
+
+    for (auto* benchmark : Benchmark::getAll())
+    {
+        if (filter.isNotEmpty() && !benchmark->name.containsIgnoreCase(filter))
+            continue;
+
+        std::cout << "--- " << benchmark->name << std::endl;
+        benchmark->function();
+    }
+    return 0;
+}
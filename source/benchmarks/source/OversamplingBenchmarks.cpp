@@ -0,0 +1,43 @@
+#include "Benchmark.h"
+
+static Benchmark oversamplingBenchmark("Oversampling", []
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int numChannels = 2;
+
+    const auto factorNames = ParametricEqualiserProcessor::getOversamplingNames();
+    const auto filterNames = ParametricEqualiserProcessor::getOversamplingFilterNames();
+
+    for (auto blockSize : { 64, 512 })
+    {
+        auto offTime = 0.0;
+        for (auto filter = 0; filter < filterNames.size(); ++filter)
+        {
+            for (auto factor = 0; factor < factorNames.size(); ++factor)
+            {
+                // Without oversampling the filter choice makes no difference.
+                if (factor == 0 && filter > 0)
+                    continue;
+
+                // The latency parameters are read when preparing, so they are set first.
+                ParametricEqualiserProcessor processor;
+                Benchmark::setParameter(processor, ParametricEqualiserProcessor::paramOversampling, float(factor));
+                Benchmark::setParameter(processor, ParametricEqualiserProcessor::paramOversamplingFilter, float(filter));
+                processor.prepareToPlay(sampleRate, blockSize);
+                Benchmark::setAllBandsToPeaks(processor);
+
+                const auto time = 1.0e9 * Benchmark::measureProcessBlock<float>(processor, numChannels, blockSize) / blockSize;
+                if (factor == 0)
+                    offTime = time;
+
+                const auto what = "oversampling " + factorNames[factor] + (factor > 0 ? ", " + filterNames[filter] : juce::String())
+                                + ", " + juce::String(blockSize) + " samples, latency " + juce::String(processor.getLatencySamples());
+                Benchmark::report(what, time, "ns/sample");
+                if (factor > 0)
+                    Benchmark::report("cost relative to off", time / offTime, "x");
+
+                processor.releaseResources();
+            }
+        }
+    }
+});
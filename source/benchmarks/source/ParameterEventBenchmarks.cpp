@@ -0,0 +1,59 @@
+#include "Benchmark.h"
+
+static Benchmark parameterEventBenchmark("Parameter events", []
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int numChannels = 2;
+    constexpr int blockSize = 512;
+
+    ParametricEqualiserProcessor processor;
+    processor.prepareToPlay(sampleRate, blockSize);
+    Benchmark::setAllBandsToPeaks(processor);
+
+    // The events move the band frequencies, so every one of them redesigns a band.
+    juce::Array<juce::AudioProcessorParameter*> frequencies;
+    for (size_t i = 0; i < processor.getNumBands(); ++i)
+        for (auto* parameter : processor.getParameters())
+            if (auto* withID = dynamic_cast<juce::AudioProcessorParameterWithID*>(parameter);
+                withID != nullptr && withID->paramID == ParametricEqualiserProcessor::getFrequencyParamName(i))
+                frequencies.add(parameter);
+
+    juce::AudioBuffer<float> input(numChannels, blockSize), buffer(numChannels, blockSize);
+    juce::MidiBuffer midi;
+    juce::Random random(1);
+    TestSignals::fillWithNoise(input, random);
+
+    // Spreads the events evenly over the block, nudging each frequency up and down around its setting.
+    auto measureWithEvents = [&](int numEvents)
+    {
+        auto direction = 1.0f;
+        return Benchmark::measure([&]
+        {
+            for (auto channel = 0; channel < numChannels; ++channel)
+                buffer.copyFrom(channel, 0, input, channel, 0, blockSize);
+
+            direction = -direction;
+            for (auto event = 0; event < numEvents; ++event)
+            {
+                auto* parameter = frequencies[event % frequencies.size()];
+                processor.addParameterEvent(parameter->getParameterIndex(),
+                                            parameter->getValue() + direction * 0.01f,
+                                            event * blockSize / numEvents);
+            }
+            processor.processBlock(buffer, midi);
+        });
+    };
+
+    const auto withoutEvents = measureWithEvents(0);
+    Benchmark::report("no events, " + juce::String(blockSize) + " samples", 1.0e9 * withoutEvents / blockSize, "ns/sample");
+
+    for (auto numEvents : { 1, 4, 16, 64 })
+    {
+        const auto withEvents = measureWithEvents(numEvents);
+        const auto what = juce::String(numEvents) + " events per block";
+        Benchmark::report(what, 1.0e9 * withEvents / blockSize, "ns/sample");
+        Benchmark::report("overhead per event", 1.0e9 * (withEvents - withoutEvents) / numEvents, "ns");
+    }
+
+    processor.releaseResources();
+});
@@ -0,0 +1,77 @@
+#include "Benchmark.h"
+
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int numChannels = 2;
+
+    template <typename SampleType>
+    double measureCascade(int blockSize)
+    {
+        const juce::dsp::ProcessSpec spec { sampleRate, juce::uint32(blockSize), juce::uint32(numChannels) };
+
+        BiquadCascadeSettings settings;
+        for (size_t i = 0; i < ParametricEqualiserProcessor::defaultNumBands; ++i)
+        {
+            settings.sections[i] = BilinearBiquadDesign::makePeakFilter(sampleRate, 60.0 * std::pow(3.0, double(i)), 1.0, i % 2 == 0 ? 2.0 : 0.5);
+            settings.enabled[i] = true;
+        }
+        BiquadCascade<SampleType> cascade;
+        cascade.prepare(spec);
+        cascade.setSettings(settings);
+        cascade.reset();
+
+        juce::AudioBuffer<SampleType> input(numChannels, blockSize), buffer(numChannels, blockSize);
+        juce::Random random(1);
+        TestSignals::fillWithNoise(input, random);
+
+        return Benchmark::measure([&]
+        {
+            for (auto channel = 0; channel < numChannels; ++channel)
+                buffer.copyFrom(channel, 0, input, channel, 0, blockSize);
+            juce::dsp::AudioBlock<SampleType> block(buffer);
+            cascade.process(juce::dsp::ProcessContextReplacing<SampleType>(block));
+        });
+    }
+
+    template <typename SampleType>
+    double measureProcessor(size_t numBands, int blockSize)
+    {
+        ParametricEqualiserProcessor processor(numBands);
+        if (std::is_same_v<SampleType, double>)
+            processor.setProcessingPrecision(juce::AudioProcessor::doublePrecision);
+        processor.prepareToPlay(sampleRate, blockSize);
+        Benchmark::setAllBandsToPeaks(processor);
+
+        const auto seconds = Benchmark::measureProcessBlock<SampleType>(processor, numChannels, blockSize);
+        processor.releaseResources();
+        return seconds;
+    }
+}
+
+static Benchmark precisionBenchmark("Float vs double", []
+{
+    for (auto blockSize : { 64, 512 })
+    {
+        const auto what = juce::String(ParametricEqualiserProcessor::defaultNumBands) + " bands, stereo, " + juce::String(blockSize) + " samples";
+        const auto floatTime = 1.0e9 * measureCascade<float>(blockSize) / blockSize;
+        const auto doubleTime = 1.0e9 * measureCascade<double>(blockSize) / blockSize;
+        Benchmark::report("BiquadCascade<float>,  " + what, floatTime, "ns/sample");
+        Benchmark::report("BiquadCascade<double>, " + what, doubleTime, "ns/sample");
+        Benchmark::report("double / float", doubleTime / floatTime, "x");
+    }
+
+    // The whole processor, with the meters, the output gain and the dynamic band bookkeeping.
+    for (auto numBands : { ParametricEqualiserProcessor::defaultNumBands, ParametricEqualiserProcessor::maxNumBands })
+    {
+        for (auto blockSize : { 64, 512 })
+        {
+            const auto what = juce::String(numBands) + " bands, stereo, " + juce::String(blockSize) + " samples";
+            const auto floatTime = 1.0e9 * measureProcessor<float>(numBands, blockSize) / blockSize;
+            const auto doubleTime = 1.0e9 * measureProcessor<double>(numBands, blockSize) / blockSize;
+            Benchmark::report("processBlock(float),  " + what, floatTime, "ns/sample");
+            Benchmark::report("processBlock(double), " + what, doubleTime, "ns/sample");
+            Benchmark::report("double / float", doubleTime / floatTime, "x");
+        }
+    }
+});
@@ -0,0 +1,68 @@
+#include "Benchmark.h"
+
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+
+    /** The grid of the processor's response curves: 300 points, ten per third of an octave from 20 Hz. */
+    std::vector<double> makeFrequencies()
+    {
+        std::vector<double> frequencies(300);
+        for (size_t i = 0; i < frequencies.size(); ++i)
+            frequencies[i] = 20.0 * std::pow(2.0, double(i) / 30.0);
+        return frequencies;
+    }
+
+    /** A peak at one of a few positions, so that consecutive updates differ like a drag does. */
+    BiquadCoefficients makeBand(int step)
+    {
+        return BilinearBiquadDesign::makePeakFilter(sampleRate, 1000.0 + 10.0 * (step % 16), 1.0, 2.0);
+    }
+}
+
+static Benchmark responseBenchmark("Response curve update", []
+{
+    const auto frequencies = makeFrequencies();
+    const auto numPoints = frequencies.size();
+
+    for (auto numBands : { ParametricEqualiserProcessor::defaultNumBands, ParametricEqualiserProcessor::maxNumBands })
+    {
+        // Before ResponseEvaluator: the changed band through juce::dsp::IIR::Coefficients, then
+        // the product of all band curves.
+        std::vector<std::vector<double>> magnitudes(numBands, std::vector<double>(numPoints, 1.0));
+        std::vector<double> total(numPoints);
+        auto step = 0;
+        const auto multiplied = Benchmark::measure([&]
+        {
+            const auto band = makeBand(++step);
+            juce::dsp::IIR::Coefficients<double> coefficients(band.b0, band.b1, band.b2, 1.0, band.a1, band.a2);
+            coefficients.getMagnitudeForFrequencyArray(frequencies.data(), magnitudes.front().data(), numPoints, sampleRate);
+
+            std::fill(total.begin(), total.end(), 1.0);
+            for (const auto& magnitude : magnitudes)
+                juce::FloatVectorOperations::multiply(total.data(), magnitude.data(), int(numPoints));
+        });
+
+        // ResponseEvaluator: the log curve of the changed band, swapped into the running sum.
+        ResponseEvaluator evaluator;
+        evaluator.prepare(frequencies, sampleRate);
+        std::vector<double> oldCurve(numPoints, 0.0), newCurve(numPoints), sum(numPoints, 0.0);
+        const auto curve = Benchmark::measure([&]
+        {
+            evaluator.process(makeBand(++step), newCurve.data());
+        });
+        const auto incremental = Benchmark::measure([&]
+        {
+            evaluator.process(makeBand(++step), newCurve.data());
+            juce::FloatVectorOperations::subtract(sum.data(), oldCurve.data(), int(numPoints));
+            juce::FloatVectorOperations::add(sum.data(), newCurve.data(), int(numPoints));
+            std::swap(oldCurve, newCurve);
+        });
+
+        const auto what = juce::String(numBands) + " bands, " + juce::String(int(numPoints)) + " points";
+        Benchmark::report("IIR::Coefficients and product, " + what, 1.0e6 * multiplied, "us/update");
+        Benchmark::report("ResponseEvaluator band curve,    " + what, 1.0e6 * curve, "us");
+        Benchmark::report("ResponseEvaluator and sum,       " + what, 1.0e6 * incremental, "us/update");
+        Benchmark::report("speed-up", multiplied / incremental, "x");
+    }
+});
@@ -0,0 +1,104 @@
+#include "Benchmark.h"
+
+namespace
+{
+    constexpr int numInstances = 1000;
+    constexpr int numDistinctInstances = 16;
+
+    /**
+     *  The state getStateInformation() wrote before the binary format: the parameter value
+     *  tree with the band count and the editor size, as XML. setStateInformation() still
+     *  reads it, through the value tree.
+     */
+    void getXmlState(ParametricEqualiserProcessor& processor, juce::MemoryBlock& destData)
+    {
+        juce::ValueTree state("PROGRAM_Name");
+        state.setProperty("num-bands", int(processor.getNumBands()), nullptr);
+        for (auto* parameter : processor.getParameters())
+        {
+            if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter))
+            {
+                juce::ValueTree child("PARAM");
+                child.setProperty("id", ranged->paramID, nullptr);
+                child.setProperty("value", ranged->convertFrom0to1(ranged->getValue()), nullptr);
+                state.appendChild(child, nullptr);
+            }
+        }
+
+        juce::ValueTree editor("editor");
+        editor.setProperty("size-x", processor.getSavedSize().x, nullptr);
+        editor.setProperty("size-y", processor.getSavedSize().y, nullptr);
+        state.appendChild(editor, nullptr);
+
+        if (auto xml = state.createXml())
+            juce::AudioProcessor::copyXmlToBinary(*xml, destData);
+    }
+}
+
+static Benchmark stateBenchmark("State save and load", []
+{
+    // A session saves and loads every instance. The instances all cost the same, so a few
+    // with different settings stand in for the whole session.
+    for (auto numBands : { ParametricEqualiserProcessor::defaultNumBands, ParametricEqualiserProcessor::maxNumBands })
+    {
+        juce::OwnedArray<ParametricEqualiserProcessor> processors;
+        juce::Random random(1);
+        for (auto i = 0; i < numDistinctInstances; ++i)
+        {
+            auto* processor = processors.add(new ParametricEqualiserProcessor(numBands));
+            for (auto* parameter : processor->getParameters())
+            {
+                // The latency parameters would re-prepare the processor, which is not what is timed.
+                if (auto* withID = dynamic_cast<juce::AudioProcessorParameterWithID*>(parameter);
+                    withID != nullptr && !ParametricEqualiserProcessor::isLatencyParameter(withID->paramID))
+                    parameter->setValueNotifyingHost(random.nextFloat());
+            }
+        }
+
+        std::vector<juce::MemoryBlock> binaryStates(numDistinctInstances), xmlStates(numDistinctInstances);
+        const auto binarySave = Benchmark::measure([&]
+        {
+            for (auto i = 0; i < numDistinctInstances; ++i)
+            {
+                binaryStates[size_t(i)].reset();
+                processors[i]->getStateInformation(binaryStates[size_t(i)]);
+            }
+        }) / numDistinctInstances;
+
+        const auto xmlSave = Benchmark::measure([&]
+        {
+            for (auto i = 0; i < numDistinctInstances; ++i)
+            {
+                xmlStates[size_t(i)].reset();
+                getXmlState(*processors[i], xmlStates[size_t(i)]);
+            }
+        }) / numDistinctInstances;
+
+        // Each instance loads the state of the next one, so that every load changes the values.
+        auto measureLoad = [&](const std::vector<juce::MemoryBlock>& states)
+        {
+            auto offset = 0;
+            return Benchmark::measure([&]
+            {
+                offset = (offset + 1) % numDistinctInstances;
+                for (auto i = 0; i < numDistinctInstances; ++i)
+                {
+                    const auto& state = states[size_t((i + offset) % numDistinctInstances)];
+                    processors[i]->setStateInformation(state.getData(), int(state.getSize()));
+                }
+            }) / numDistinctInstances;
+        };
+        const auto binaryLoad = measureLoad(binaryStates);
+        const auto xmlLoad = measureLoad(xmlStates);
+
+        const auto what = juce::String(numBands) + " bands, " + juce::String(numInstances) + " instances";
+        Benchmark::report("binary save, " + what, 1.0e3 * binarySave * numInstances, "ms");
+        Benchmark::report("XML save,    " + what, 1.0e3 * xmlSave * numInstances, "ms");
+        Benchmark::report("speed-up", xmlSave / binarySave, "x");
+        Benchmark::report("binary load, " + what, 1.0e3 * binaryLoad * numInstances, "ms");
+        Benchmark::report("XML load,    " + what, 1.0e3 * xmlLoad * numInstances, "ms");
+        Benchmark::report("speed-up", xmlLoad / binaryLoad, "x");
+        Benchmark::report("binary state size", double(binaryStates.front().getSize()), "bytes");
+        Benchmark::report("XML state size", double(xmlStates.front().getSize()), "bytes");
+    }
+});
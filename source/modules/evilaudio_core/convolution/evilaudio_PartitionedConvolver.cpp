@@ -0,0 +1,272 @@
+#include "evilaudio_PartitionedConvolver.h"
+
+PartitionedConvolver::PartitionedConvolver()
+{
+    for (auto& slot : _tailSlotBlocks)
+        slot = -1;
+}
+
+PartitionedConvolver::~PartitionedConvolver()
+{
+    stopTail();
+}
+
+void PartitionedConvolver::prepare(const juce::dsp::ProcessSpec& spec, size_t maxImpulseLength)
+{
+    stopTail();
+
+    _numChannels = size_t(spec.numChannels);
+    _maxBlockSize = juce::jmax(size_t(1), size_t(spec.maximumBlockSize));
+    _maxImpulseLength = maxImpulseLength;
+
+    // The tail thread gets one tail partition of slack, which must cover at least a whole
+    // host block, otherwise a block could be due within the callback that completed it.
+    _tailPartitionSize = size_t(juce::jmax(1024, juce::nextPowerOfTwo(int(_maxBlockSize))));
+    _tailStart = 2 * _tailPartitionSize;
+
+    _head.assign(headSize, 0.0f);
+    _headHistory.assign(_numChannels, std::vector<float>(2 * headSize, 0.0f));
+    _headPosition = 0;
+
+    _segment.prepare(_numChannels, headSize, _tailStart - headSize);
+    _dry.assign(_numChannels, std::vector<float>(_maxBlockSize, 0.0f));
+    _wet.assign(_numChannels, std::vector<float>(_maxBlockSize, 0.0f));
+    _wetPointers.resize(_numChannels);
+    for (size_t channel = 0; channel < _numChannels; ++channel)
+        _wetPointers[channel] = _wet[channel].data();
+
+    _tail.prepare(_numChannels, _tailPartitionSize, juce::jmax(_tailPartitionSize, maxImpulseLength - juce::jmin(maxImpulseLength, _tailStart)));
+    _tailInput.assign(_numChannels, std::vector<float>(numTailSlots * _tailPartitionSize, 0.0f));
+    _tailOutput.assign(_numChannels, std::vector<float>(numTailSlots * _tailPartitionSize, 0.0f));
+    _tailInputPointers.resize(_numChannels);
+    _tailOutputPointers.resize(_numChannels);
+    _hasTail = false;
+    _numUnderruns = 0;
+
+    clearTail();
+}
+
+void PartitionedConvolver::loadImpulseResponse(const float* impulse, size_t length)
+{
+    jassert(_numChannels > 0);
+    stopTail();
+
+    length = juce::jmin(length, _maxImpulseLength);
+    std::fill(_head.begin(), _head.end(), 0.0f);
+    std::copy(impulse, impulse + juce::jmin(length, headSize), _head.begin());
+
+    // Preparing again drops the previous kernels, so the new ones are used without a crossfade.
+    _segment.prepare(_numChannels, headSize, _tailStart - headSize);
+    if (length > headSize)
+        _segment.setKernel(impulse + headSize, juce::jmin(length, _tailStart) - headSize);
+
+    _tail.prepare(_numChannels, _tailPartitionSize, juce::jmax(_tailPartitionSize, _maxImpulseLength - juce::jmin(_maxImpulseLength, _tailStart)));
+    _hasTail = length > _tailStart;
+    if (_hasTail)
+        _tail.setKernel(impulse + _tailStart, length - _tailStart);
+
+    for (auto& channel : _headHistory)
+        std::fill(channel.begin(), channel.end(), 0.0f);
+    _headPosition = 0;
+
+    clearTail();
+    startTail();
+}
+
+void PartitionedConvolver::reset()
+{
+    stopTail();
+
+    for (auto& channel : _headHistory)
+        std::fill(channel.begin(), channel.end(), 0.0f);
+    _headPosition = 0;
+    _segment.reset();
+    _tail.reset();
+
+    clearTail();
+    startTail();
+}
+
+int PartitionedConvolver::getNumUnderruns() const noexcept
+{
+    return _numUnderruns.load();
+}
+
+size_t PartitionedConvolver::getTailPartitionSize() const noexcept
+{
+    return _tailPartitionSize;
+}
+
+void PartitionedConvolver::process(const juce::dsp::ProcessContextReplacing<float>& context) noexcept
+{
+    auto& block = context.getOutputBlock();
+    const auto numChannels = juce::jmin(_numChannels, size_t(block.getNumChannels()));
+    const auto numSamples = block.getNumSamples();
+
+    if (context.isBypassed)
+        return;
+
+    for (size_t offset = 0; offset < numSamples; offset += _maxBlockSize)
+    {
+        const auto numToDo = juce::jmin(_maxBlockSize, numSamples - offset);
+
+        for (size_t channel = 0; channel < numChannels; ++channel)
+        {
+            const auto* source = block.getChannelPointer(channel) + offset;
+            std::copy(source, source + numToDo, _dry[channel].begin());
+            std::copy(source, source + numToDo, _wet[channel].begin());
+        }
+
+        // The segment convolver delays by headSize, which is where its taps start.
+        _segment.process(juce::dsp::AudioBlock<float>(_wetPointers.data(), numChannels, numToDo));
+        processHead(numChannels, numToDo);
+        if (_hasTail)
+            processTail(numChannels, numToDo);
+
+        for (size_t channel = 0; channel < numChannels; ++channel)
+            std::copy(_wet[channel].begin(), _wet[channel].begin() + std::ptrdiff_t(numToDo), block.getChannelPointer(channel) + offset);
+    }
+}
+
+void PartitionedConvolver::processHead(size_t numChannels, size_t numSamples) noexcept
+{
+    const auto* taps = _head.data();
+    auto position = _headPosition;
+
+    for (size_t channel = 0; channel < numChannels; ++channel)
+    {
+        auto* history = _headHistory[channel].data();
+        const auto* dry = _dry[channel].data();
+        auto* wet = _wet[channel].data();
+        position = _headPosition;
+
+        for (size_t i = 0; i < numSamples; ++i)
+        {
+            history[position] = history[position + headSize] = dry[i];
+
+            // history[position + headSize - k] holds the input from k samples ago.
+            const auto* newest = history + position + headSize;
+            auto sum = 0.0f;
+            for (size_t k = 0; k < headSize; ++k)
+                sum += taps[k] * newest[-std::ptrdiff_t(k)];
+            wet[i] += sum;
+
+            position = (position + 1) % headSize;
+        }
+    }
+
+    _headPosition = position;
+}
+
+void PartitionedConvolver::processTail(size_t numChannels, size_t numSamples) noexcept
+{
+    const auto T = _tailPartitionSize;
+
+    for (size_t i = 0; i < numSamples;)
+    {
+        // Input block j is due as output block j + 2, so while block j is being collected
+        // the output of block j - 2 is played back.
+        const auto outputBlock = _tailBlock - 2;
+        if (_tailFill == 0)
+        {
+            _tailOutputReady = outputBlock >= 0
+                && _tailSlotBlocks[size_t(outputBlock % juce::int64(numTailSlots))].load(std::memory_order_acquire) == outputBlock;
+
+            if (outputBlock >= 0 && !_tailOutputReady)
+                ++_numUnderruns;
+        }
+
+        const auto numToDo = juce::jmin(numSamples - i, T - _tailFill);
+        const auto inputOffset = size_t(_tailBlock % juce::int64(numTailSlots)) * T + _tailFill;
+        const auto outputOffset = size_t((outputBlock + juce::int64(numTailSlots)) % juce::int64(numTailSlots)) * T + _tailFill;
+
+        for (size_t channel = 0; channel < numChannels; ++channel)
+        {
+            const auto* dry = _dry[channel].data() + i;
+            std::copy(dry, dry + numToDo, _tailInput[channel].begin() + std::ptrdiff_t(inputOffset));
+
+            if (_tailOutputReady)
+                juce::FloatVectorOperations::add(_wet[channel].data() + i, _tailOutput[channel].data() + outputOffset, int(numToDo));
+        }
+
+        _tailFill += numToDo;
+        i += numToDo;
+
+        if (_tailFill == T)
+        {
+            _tailFill = 0;
+            ++_tailBlock;
+            _tailBlocksSubmitted.store(_tailBlock, std::memory_order_release);
+        }
+    }
+}
+
+bool PartitionedConvolver::renderNextTailBlock()
+{
+    const auto submitted = _tailBlocksSubmitted.load(std::memory_order_acquire);
+    if (_nextTailBlock >= submitted)
+        return false;
+
+    // If the input of a block has already been overwritten, skip ahead. The audio thread
+    // has counted the missing blocks as underruns.
+    if (submitted - _nextTailBlock > juce::int64(numTailSlots) - 2)
+        _nextTailBlock = submitted - 1;
+
+    const auto block = _nextTailBlock;
+    const auto offset = size_t(block % juce::int64(numTailSlots)) * _tailPartitionSize;
+    for (size_t channel = 0; channel < _numChannels; ++channel)
+    {
+        _tailInputPointers[channel] = _tailInput[channel].data() + offset;
+        _tailOutputPointers[channel] = _tailOutput[channel].data() + offset;
+    }
+
+    _tail.convolvePartition(_tailInputPointers.data(), _tailOutputPointers.data(), _numChannels);
+    _tailSlotBlocks[size_t(block % juce::int64(numTailSlots))].store(block, std::memory_order_release);
+    ++_nextTailBlock;
+    return true;
+}
+
+void PartitionedConvolver::clearTail()
+{
+    for (auto& channel : _tailInput)
+        std::fill(channel.begin(), channel.end(), 0.0f);
+    for (auto& channel : _tailOutput)
+        std::fill(channel.begin(), channel.end(), 0.0f);
+    for (auto& slot : _tailSlotBlocks)
+        slot = -1;
+
+    _tailFill = 0;
+    _tailBlock = 0;
+    _tailOutputReady = false;
+    _nextTailBlock = 0;
+    _tailBlocksSubmitted = 0;
+}
+
+void PartitionedConvolver::startTail()
+{
+    if (_hasTail)
+        _tailThread.startThread(juce::Thread::Priority::high);
+}
+
+void PartitionedConvolver::stopTail()
+{
+    _tailThread.stopThread(1000);
+}
+
+//==============================================================================
+
+PartitionedConvolver::TailThread::TailThread(PartitionedConvolver& owner) :
+    juce::Thread("Convolution-Tail"),
+    _owner(owner)
+{
+}
+
+void PartitionedConvolver::TailThread::run()
+{
+    // Polled, as waking this thread from the audio thread would lock the event's mutex.
+    while (!threadShouldExit())
+    {
+        if (!_owner.renderNextTailBlock())
+            wait(tailPollMilliseconds);
+    }
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <vector>
+
+#include "juce_dsp/juce_dsp.h"
+#include "evilaudio_UniformPartitionedConvolver.h"
+
+/**
+ *  Zero latency convolution with long impulse responses.
+ *
+ *  The impulse response is cut into three segments with growing partition sizes:
+ *   - the head, the first headSize taps, is applied directly in the time domain, so the
+ *     output is not delayed at all;
+ *   - the taps up to twice the tail partition size T are run on the audio thread by a
+ *     UniformPartitionedConvolver with partitions of headSize, whose buffering delay is
+ *     exactly where its segment starts;
+ *   - the remaining tail is run on a background thread with partitions of T. A block of
+ *     T input samples is complete one block period before its contribution is due, which
+ *     is the slack that thread has.
+ *
+ *  The same (mono) impulse response is applied to every channel. Nothing is allocated in
+ *  process(); if the background thread misses a deadline, the tail of that block is left
+ *  out and counted in getNumUnderruns().
+ *
+ *  @note prepare(), loadImpulseResponse() and reset() must not be called while process()
+ *        is running.
+ */
+class PartitionedConvolver
+{
+public:
+    static constexpr size_t headSize = 64;
+
+    PartitionedConvolver();
+    ~PartitionedConvolver();
+
+    /** Allocates for the given channels and block size and for impulses up to maxImpulseLength samples. */
+    void prepare(const juce::dsp::ProcessSpec& spec, size_t maxImpulseLength);
+
+    /** Sets the impulse response, truncated to the length given to prepare(), and clears the history. */
+    void loadImpulseResponse(const float* impulse, size_t length);
+
+    /** Clears the signal history, keeping the impulse response. */
+    void reset();
+
+    void process(const juce::dsp::ProcessContextReplacing<float>& context) noexcept;
+
+    /** Returns how many blocks of the tail were dropped because the background thread was late. */
+    int getNumUnderruns() const noexcept;
+
+    /** The partition size used for the tail, T. The tail starts at 2T samples. */
+    size_t getTailPartitionSize() const noexcept;
+
+private:
+    /** Renders the tail partitions the audio thread has collected, looking for them every tailPollMilliseconds. */
+    class TailThread : public juce::Thread
+    {
+    public:
+        explicit TailThread(PartitionedConvolver& owner);
+        void run() override;
+
+    private:
+        PartitionedConvolver& _owner;
+    };
+
+    void processHead(size_t numChannels, size_t numSamples) noexcept;
+    void processTail(size_t numChannels, size_t numSamples) noexcept;
+    bool renderNextTailBlock();
+    void clearTail();
+    void startTail();
+    void stopTail();
+
+    static constexpr size_t numTailSlots = 8;
+    /** How often the tail thread looks for new blocks, well within the 5 ms of the shortest partition at 192 kHz. */
+    static constexpr int tailPollMilliseconds = 1;
+
+    size_t _numChannels = 0;
+    size_t _maxBlockSize = 0;
+    size_t _tailPartitionSize = 0;
+    size_t _tailStart = 0;
+    size_t _maxImpulseLength = 0;
+
+    // Head, applied directly. The history is stored twice so the taps can run over it without wrapping.
+    std::vector<float> _head;
+    std::vector<std::vector<float>> _headHistory;
+    size_t _headPosition = 0;
+
+    UniformPartitionedConvolver _segment;
+    std::vector<std::vector<float>> _dry, _wet;
+    std::vector<float*> _wetPointers;
+
+    // Tail, handed to and from the background thread through rings of numTailSlots blocks.
+    UniformPartitionedConvolver _tail;
+    bool _hasTail = false;
+    std::vector<std::vector<float>> _tailInput, _tailOutput;
+    std::vector<const float*> _tailInputPointers;
+    std::vector<float*> _tailOutputPointers;
+    size_t _tailFill = 0;
+    juce::int64 _tailBlock = 0;
+    bool _tailOutputReady = false;
+    juce::int64 _nextTailBlock = 0;
+    std::atomic<juce::int64> _tailBlocksSubmitted{ 0 };
+    std::array<std::atomic<juce::int64>, numTailSlots> _tailSlotBlocks;
+    std::atomic<int> _numUnderruns{ 0 };
+    TailThread _tailThread{ *this };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PartitionedConvolver)
+};
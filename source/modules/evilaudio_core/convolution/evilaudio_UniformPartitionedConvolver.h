@@ -0,0 +1,345 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "juce_dsp/juce_dsp.h"
+
+/**
+ *  Uniformly partitioned overlap-save FFT convolution with click-free kernel changes.
+ *
+ *  The kernel is cut into partitions of the block size B, each of which is transformed
+ *  once; every B input samples one forward FFT, a multiply-accumulate over all
+ *  partitions in a frequency domain delay line and one inverse FFT produce the next B
+ *  output samples. Input is collected into whole partitions, so the output is delayed
+ *  by getLatencyInSamples() regardless of the host block size.
+ *
+ *  Kernels are handed over from a background thread: setKernel() transforms the new
+ *  kernel into a spare bank, and the audio thread crossfades from the old output to the
+ *  new one. Nothing is allocated after prepare().
+ *
+ *  @note process() and reset() belong to the audio thread, isReadyForKernel() and
+ *        setKernel() to a single background thread, and prepare() must only be called
+ *        while neither of them is running.
+ */
+class UniformPartitionedConvolver
+{
+public:
+    UniformPartitionedConvolver() = default;
+
+    /**
+     *  Allocates everything for the given channel count, partition size (a power of two)
+     *  and the longest kernel that will be passed to setKernel().
+     */
+    void prepare(size_t numChannels, size_t partitionSize, size_t maxKernelLength)
+    {
+        jassert(juce::isPowerOfTwo(partitionSize));
+
+        _numChannels = numChannels;
+        _partitionSize = partitionSize;
+        _numBins = partitionSize + 1;
+        _numPartitions = juce::jmax(size_t(1), (maxKernelLength + partitionSize - 1) / partitionSize);
+
+        const auto fftOrder = juce::roundToInt(std::log2(double(2 * partitionSize)));
+        _fft = std::make_unique<juce::dsp::FFT>(fftOrder);
+        _kernelFft = std::make_unique<juce::dsp::FFT>(fftOrder);
+
+        _input.assign(numChannels, std::vector<float>(2 * partitionSize, 0.0f));
+        _output.assign(numChannels, std::vector<float>(partitionSize, 0.0f));
+        _delayLineReal.assign(numChannels, std::vector<float>(_numPartitions * _numBins, 0.0f));
+        _delayLineImag.assign(numChannels, std::vector<float>(_numPartitions * _numBins, 0.0f));
+        _accumulatorReal.assign(_numBins, 0.0f);
+        _accumulatorImag.assign(_numBins, 0.0f);
+        _fftBuffer.assign(4 * partitionSize, 0.0f);
+        _fadeBuffer.assign(partitionSize, 0.0f);
+        _kernelFftBuffer.assign(4 * partitionSize, 0.0f);
+
+        for (auto& bank : _banks)
+        {
+            bank.real.assign(_numPartitions * _numBins, 0.0f);
+            bank.imag.assign(_numPartitions * _numBins, 0.0f);
+            bank.numPartitions = 0;
+        }
+
+        _fadeLength = juce::jmax(size_t(1), defaultFadeSamples / partitionSize) * partitionSize;
+        _fadeRemaining = 0;
+        _activeBank = 0;
+        _hasKernel = false;
+        _handoff = handoffFree;
+        reset();
+    }
+
+    /** Clears the signal history, keeping the current kernel. */
+    void reset() noexcept
+    {
+        for (auto& channel : _input)        std::fill(channel.begin(), channel.end(), 0.0f);
+        for (auto& channel : _output)       std::fill(channel.begin(), channel.end(), 0.0f);
+        for (auto& channel : _delayLineReal) std::fill(channel.begin(), channel.end(), 0.0f);
+        for (auto& channel : _delayLineImag) std::fill(channel.begin(), channel.end(), 0.0f);
+        _fill = 0;
+        _delayLineHead = 0;
+    }
+
+    /** The delay added by collecting input into whole partitions. */
+    int getLatencyInSamples() const noexcept
+    {
+        return int(_partitionSize);
+    }
+
+    size_t getMaxKernelLength() const noexcept
+    {
+        return _numPartitions * _partitionSize;
+    }
+
+    /** Returns true if the spare bank is free, i.e. the previous kernel has been taken over. */
+    bool isReadyForKernel() const noexcept
+    {
+        return _handoff.load(std::memory_order_acquire) == handoffFree;
+    }
+
+    /**
+     *  Transforms a kernel into the spare bank and hands it to the audio thread.
+     *
+     *  Only call this once isReadyForKernel() has returned true. Kernels longer than
+     *  getMaxKernelLength() are truncated.
+     */
+    void setKernel(const float* kernel, size_t length) noexcept
+    {
+        jassert(isReadyForKernel());
+
+        auto& bank = _banks[size_t(1 - _activeBank.load(std::memory_order_relaxed))];
+        length = juce::jmin(length, getMaxKernelLength());
+        bank.numPartitions = (length + _partitionSize - 1) / _partitionSize;
+
+        for (size_t p = 0; p < bank.numPartitions; ++p)
+        {
+            const auto offset = p * _partitionSize;
+            const auto numSamples = juce::jmin(_partitionSize, length - offset);
+
+            std::fill(_kernelFftBuffer.begin(), _kernelFftBuffer.end(), 0.0f);
+            std::copy(kernel + offset, kernel + offset + numSamples, _kernelFftBuffer.begin());
+            _kernelFft->performRealOnlyForwardTransform(_kernelFftBuffer.data(), true);
+
+            for (size_t k = 0; k < _numBins; ++k)
+            {
+                bank.real[p * _numBins + k] = _kernelFftBuffer[2 * k];
+                bank.imag[p * _numBins + k] = _kernelFftBuffer[2 * k + 1];
+            }
+        }
+
+        _handoff.store(handoffPending, std::memory_order_release);
+    }
+
+    /** Convolves the block in place. The block may have any length. */
+    template <typename SampleType>
+    void process(const juce::dsp::AudioBlock<SampleType>& block) noexcept
+    {
+        const auto numChannels = juce::jmin(_numChannels, size_t(block.getNumChannels()));
+        const auto numSamples = block.getNumSamples();
+
+        for (size_t done = 0; done < numSamples;)
+        {
+            const auto numToDo = juce::jmin(numSamples - done, _partitionSize - _fill);
+
+            for (size_t channel = 0; channel < numChannels; ++channel)
+            {
+                auto* samples = block.getChannelPointer(channel) + done;
+                auto* input = _input[channel].data() + _partitionSize + _fill;
+                const auto* output = _output[channel].data() + _fill;
+
+                for (size_t i = 0; i < numToDo; ++i)
+                {
+                    input[i] = float(samples[i]);
+                    samples[i] = SampleType(output[i]);
+                }
+            }
+
+            _fill += numToDo;
+            done += numToDo;
+
+            if (_fill == _partitionSize)
+            {
+                processPartition(numChannels);
+                _fill = 0;
+            }
+        }
+    }
+
+    /**
+     *  Convolves exactly one partition of input, without the buffering delay of process().
+     *
+     *  For callers that already work in whole partitions, such as a background thread
+     *  rendering the tail of a longer convolution. Don't mix this with process() between
+     *  two calls to reset().
+     */
+    void convolvePartition(const float* const* input, float* const* output, size_t numChannels) noexcept
+    {
+        numChannels = juce::jmin(numChannels, _numChannels);
+
+        for (size_t channel = 0; channel < numChannels; ++channel)
+            std::copy(input[channel], input[channel] + _partitionSize, _input[channel].begin() + std::ptrdiff_t(_partitionSize));
+
+        processPartition(numChannels);
+
+        for (size_t channel = 0; channel < numChannels; ++channel)
+            std::copy(_output[channel].begin(), _output[channel].end(), output[channel]);
+    }
+
+    size_t getPartitionSize() const noexcept
+    {
+        return _partitionSize;
+    }
+
+private:
+    struct KernelBank
+    {
+        std::vector<float> real, imag;
+        size_t numPartitions = 0;
+    };
+
+    void processPartition(size_t numChannels) noexcept
+    {
+        takeOverPendingKernel();
+
+        const auto activeBank = size_t(_activeBank.load(std::memory_order_relaxed));
+        _delayLineHead = (_delayLineHead + _numPartitions - 1) % _numPartitions;
+
+        for (size_t channel = 0; channel < numChannels; ++channel)
+        {
+            // Transform the last two partitions of input into the newest delay line slot.
+            auto& input = _input[channel];
+            std::fill(_fftBuffer.begin(), _fftBuffer.end(), 0.0f);
+            std::copy(input.begin(), input.end(), _fftBuffer.begin());
+            std::copy(input.begin() + std::ptrdiff_t(_partitionSize), input.end(), input.begin());
+            _fft->performRealOnlyForwardTransform(_fftBuffer.data(), true);
+
+            auto* slotReal = _delayLineReal[channel].data() + _delayLineHead * _numBins;
+            auto* slotImag = _delayLineImag[channel].data() + _delayLineHead * _numBins;
+            for (size_t k = 0; k < _numBins; ++k)
+            {
+                slotReal[k] = _fftBuffer[2 * k];
+                slotImag[k] = _fftBuffer[2 * k + 1];
+            }
+
+            auto* output = _output[channel].data();
+            if (_fadeRemaining > 0)
+            {
+                // Render with both kernels and crossfade, the input history is shared.
+                convolve(channel, _banks[1 - activeBank], _fadeBuffer.data());
+                convolve(channel, _banks[activeBank], output);
+
+                const auto fadePosition = _fadeLength - _fadeRemaining;
+                for (size_t i = 0; i < _partitionSize; ++i)
+                {
+                    const auto gain = float(fadePosition + i) / float(_fadeLength);
+                    output[i] = _fadeBuffer[i] + gain * (output[i] - _fadeBuffer[i]);
+                }
+            }
+            else
+            {
+                convolve(channel, _banks[activeBank], output);
+            }
+        }
+
+        if (_fadeRemaining > 0)
+        {
+            _fadeRemaining -= _partitionSize;
+            if (_fadeRemaining == 0)
+                _handoff.store(handoffFree, std::memory_order_release);
+        }
+    }
+
+    /** Starts a crossfade to a kernel published by setKernel(). */
+    void takeOverPendingKernel() noexcept
+    {
+        if (_fadeRemaining > 0 || _handoff.load(std::memory_order_acquire) != handoffPending)
+            return;
+
+        _activeBank.store(1 - _activeBank.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+        if (_hasKernel)
+        {
+            _fadeRemaining = _fadeLength;
+        }
+        else
+        {
+            // Nothing to fade from, the first kernel is used right away.
+            _hasKernel = true;
+            _handoff.store(handoffFree, std::memory_order_release);
+        }
+    }
+
+    /** Multiplies the delay line with a kernel bank and writes the last B samples of the result. */
+    void convolve(size_t channel, const KernelBank& bank, float* destination) noexcept
+    {
+        std::fill(_accumulatorReal.begin(), _accumulatorReal.end(), 0.0f);
+        std::fill(_accumulatorImag.begin(), _accumulatorImag.end(), 0.0f);
+
+        auto* accumulatorReal = _accumulatorReal.data();
+        auto* accumulatorImag = _accumulatorImag.data();
+
+        for (size_t p = 0; p < bank.numPartitions; ++p)
+        {
+            const auto slot = (_delayLineHead + p) % _numPartitions;
+            const auto* xr = _delayLineReal[channel].data() + slot * _numBins;
+            const auto* xi = _delayLineImag[channel].data() + slot * _numBins;
+            const auto* hr = bank.real.data() + p * _numBins;
+            const auto* hi = bank.imag.data() + p * _numBins;
+
+            for (size_t k = 0; k < _numBins; ++k)
+            {
+                accumulatorReal[k] += xr[k] * hr[k] - xi[k] * hi[k];
+                accumulatorImag[k] += xr[k] * hi[k] + xi[k] * hr[k];
+            }
+        }
+
+        // Rebuild the full conjugate symmetric spectrum for the inverse transform.
+        const auto fftSize = 2 * _partitionSize;
+        for (size_t k = 0; k < _numBins; ++k)
+        {
+            _fftBuffer[2 * k] = accumulatorReal[k];
+            _fftBuffer[2 * k + 1] = accumulatorImag[k];
+        }
+        for (size_t k = _numBins; k < fftSize; ++k)
+        {
+            _fftBuffer[2 * k] = accumulatorReal[fftSize - k];
+            _fftBuffer[2 * k + 1] = -accumulatorImag[fftSize - k];
+        }
+
+        _fft->performRealOnlyInverseTransform(_fftBuffer.data());
+        std::copy(_fftBuffer.begin() + std::ptrdiff_t(_partitionSize), _fftBuffer.begin() + std::ptrdiff_t(fftSize), destination);
+    }
+
+    static constexpr size_t defaultFadeSamples = 2048;
+    static constexpr int handoffFree = 0;
+    static constexpr int handoffPending = 1;
+
+    size_t _numChannels = 0;
+    size_t _partitionSize = 0;
+    size_t _numBins = 0;
+    size_t _numPartitions = 0;
+
+    std::unique_ptr<juce::dsp::FFT> _fft;
+    std::vector<std::vector<float>> _input, _output;
+    std::vector<std::vector<float>> _delayLineReal, _delayLineImag;
+    std::vector<float> _accumulatorReal, _accumulatorImag;
+    std::vector<float> _fftBuffer, _fadeBuffer;
+    size_t _fill = 0;
+    size_t _delayLineHead = 0;
+    size_t _fadeLength = 1;
+    size_t _fadeRemaining = 0;
+    bool _hasKernel = false;
+
+    // The audio thread owns _activeBank; the other bank belongs to setKernel() whenever
+    // _handoff is free, and to the audio thread from the moment a kernel is pending.
+    std::array<KernelBank, 2> _banks;
+    std::atomic<int> _activeBank{ 0 };
+    std::atomic<int> _handoff{ handoffFree };
+
+    std::unique_ptr<juce::dsp::FFT> _kernelFft;
+    std::vector<float> _kernelFftBuffer;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(UniformPartitionedConvolver)
+};
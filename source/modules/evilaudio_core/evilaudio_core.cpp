@@ -0,0 +1,13 @@
+#ifdef EVILAUDIO_CORE_H_INCLUDED
+    /* 
+    When you add this cpp file to your project, you mustn't include it in a file where you've
+    already included any other headers - just put it inside a file on its own, possibly with your config
+    flags preceding it, but don't include anything else. That also includes avoiding any automatic prefix
+    header files that the compiler may be using.
+    */
+    #error "Incorrect use of EvilAudio module cpp file"
+#endif
+
+#include "evilaudio_core.h"
+
+#include "convolution/evilaudio_PartitionedConvolver.cpp"
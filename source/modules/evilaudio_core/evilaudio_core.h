@@ -1,2 +1,7 @@
 #pragma once
 
+#define EVILAUDIO_CORE_H_INCLUDED
+
+#include "convolution/evilaudio_UniformPartitionedConvolver.h"
+#include "convolution/evilaudio_PartitionedConvolver.h"
+#include "metering/evilaudio_LoudnessMeter.h"
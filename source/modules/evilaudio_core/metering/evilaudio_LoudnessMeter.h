@@ -0,0 +1,335 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <vector>
+
+#include "juce_dsp/juce_dsp.h"
+
+/**
+ *  Loudness meter after ITU-R BS.1770-4 and EBU R 128.
+ *
+ *  The channels are K-weighted (a high shelf for the head, followed by the RLB high pass),
+ *  weighted by position and summed as mean squares over steps of 100 ms. The momentary
+ *  loudness covers the last 4 steps, the short-term loudness the last 30, and every step
+ *  completes a 400 ms gating block that goes into the integrated loudness.
+ *
+ *  The integrated loudness is gated absolutely at -70 LUFS and relatively at 10 LU below
+ *  the loudness of the blocks above the absolute gate. Instead of keeping every block, the
+ *  blocks are counted in a histogram of 0.1 LU bins that also sums their energy, so the
+ *  gates cost a fixed walk over the bins however long the measurement runs. The relative
+ *  gate is placed on a bin edge, which moves it by less than 0.1 LU.
+ *
+ *  Nothing is allocated after prepare(). The readings are published through atomics and can
+ *  be polled from any thread, e.g. an editor, a host's meter bridge or an offline analysis.
+ *
+ *  @note process(), processSilence() and reset() belong to the thread that feeds audio,
+ *        prepare() and setChannelWeight() must only be called while it is not running.
+ */
+class LoudnessMeter
+{
+public:
+    /** Loudness in LUFS. Readings without any signal above the absolute gate are minLoudness. */
+    struct Loudness
+    {
+        float momentary = minLoudness;
+        float shortTerm = minLoudness;
+        float integrated = minLoudness;
+    };
+
+    static constexpr float minLoudness = -100.0f;
+    static constexpr double absoluteGate = -70.0;
+    static constexpr double relativeGate = -10.0;
+
+    LoudnessMeter() = default;
+
+    /** Allocates the filter states and designs the K-weighting for a sample rate. */
+    void prepare(double sampleRate, int numChannels)
+    {
+        _numChannels = size_t(juce::jmax(0, numChannels));
+        _states.assign(_numChannels, {});
+        _weights.assign(_numChannels, 1.0);
+        _stepLength = size_t(juce::jmax(1, juce::roundToInt(0.1 * sampleRate)));
+        designKWeighting(sampleRate);
+        reset();
+    }
+
+    /** Sets the weight of a channel in the sum, see getChannelWeight(). */
+    void setChannelWeight(int channel, double weight)
+    {
+        if (juce::isPositiveAndBelow(channel, _weights.size()))
+            _weights[size_t(channel)] = weight;
+    }
+
+    /** Weights all channels by their position in a layout. */
+    void setChannelLayout(const juce::AudioChannelSet& layout)
+    {
+        for (int channel = 0; channel < int(_weights.size()); ++channel)
+            setChannelWeight(channel, channel < layout.size() ? getChannelWeight(layout.getTypeOfChannel(channel)) : 1.0);
+    }
+
+    /**
+     *  Returns the BS.1770 weight of a channel: 0 for low frequency effects, about +1.5 dB
+     *  for the surround channels, and 1 for the front and everything else.
+     */
+    static double getChannelWeight(juce::AudioChannelSet::ChannelType type) noexcept
+    {
+        switch (type)
+        {
+            case juce::AudioChannelSet::LFE:
+            case juce::AudioChannelSet::LFE2:
+                return 0.0;
+            case juce::AudioChannelSet::leftSurround:
+            case juce::AudioChannelSet::rightSurround:
+            case juce::AudioChannelSet::leftSurroundSide:
+            case juce::AudioChannelSet::rightSurroundSide:
+            case juce::AudioChannelSet::leftSurroundRear:
+            case juce::AudioChannelSet::rightSurroundRear:
+                return 1.41;
+            default:
+                return 1.0;
+        }
+    }
+
+    /** Clears the filters, the windows and the integrated measurement. */
+    void reset() noexcept
+    {
+        for (auto& state : _states)
+            state = {};
+        _steps.fill(0.0);
+        _stepIndex = 0;
+        _numSteps = 0;
+        _stepEnergy = 0.0;
+        _stepPosition = 0;
+        clearHistogram();
+        _resetRequested = false;
+        publish(0.0, 0.0);
+    }
+
+    /** Starts the integrated measurement again with the next block. Can be called from any thread. */
+    void resetIntegrated() noexcept
+    {
+        _resetRequested = true;
+    }
+
+    /** Measures a block of audio without changing it. */
+    template <typename SampleType>
+    void process(const juce::dsp::AudioBlock<SampleType>& block) noexcept
+    {
+        const auto numChannels = juce::jmin(_numChannels, size_t(block.getNumChannels()));
+        const auto numSamples = block.getNumSamples();
+
+        for (size_t offset = 0; offset < numSamples;)
+        {
+            const auto numToDo = juce::jmin(numSamples - offset, _stepLength - _stepPosition);
+            for (size_t channel = 0; channel < numChannels; ++channel)
+            {
+                if (_weights[channel] == 0.0)
+                    continue;
+
+                // Both stages in transposed direct form II, in double precision because the
+                // high pass sits at a few ten Hertz.
+                auto state = _states[channel];
+                const auto* samples = block.getChannelPointer(channel) + offset;
+                auto sum = 0.0;
+                for (size_t i = 0; i < numToDo; ++i)
+                {
+                    const auto x = double(samples[i]);
+                    const auto shelved = _shelf[0] * x + state[0];
+                    state[0] = _shelf[1] * x - _shelf[3] * shelved + state[1];
+                    state[1] = _shelf[2] * x - _shelf[4] * shelved;
+
+                    const auto weighted = _highPass[0] * shelved + state[2];
+                    state[2] = _highPass[1] * shelved - _highPass[3] * weighted + state[3];
+                    state[3] = _highPass[2] * shelved - _highPass[4] * weighted;
+                    sum += weighted * weighted;
+                }
+                _states[channel] = state;
+                _stepEnergy += _weights[channel] * sum;
+            }
+
+            advance(numToDo);
+            offset += numToDo;
+        }
+    }
+
+    /**
+     *  Counts a stretch of digital silence without filtering it, for callers that skip
+     *  processing while the input is silent. The filter states are cleared.
+     */
+    void processSilence(size_t numSamples) noexcept
+    {
+        for (auto& state : _states)
+            state = {};
+
+        // Past the longest window, whatever is left of it only holds silence.
+        numSamples = juce::jmin(numSamples, (numShortTermSteps + 1) * _stepLength);
+        while (numSamples > 0)
+        {
+            const auto numToDo = juce::jmin(numSamples, _stepLength - _stepPosition);
+            advance(numToDo);
+            numSamples -= numToDo;
+        }
+    }
+
+    /** Returns the latest readings. Can be called from any thread. */
+    Loudness getLoudness() const noexcept
+    {
+        Loudness loudness;
+        loudness.momentary = _momentary.load(std::memory_order_relaxed);
+        loudness.shortTerm = _shortTerm.load(std::memory_order_relaxed);
+        loudness.integrated = _integrated.load(std::memory_order_relaxed);
+        return loudness;
+    }
+
+private:
+    static constexpr size_t numMomentarySteps = 4;
+    static constexpr size_t numShortTermSteps = 30;
+    static constexpr double binWidth = 0.1;
+    static constexpr double maxHistogramLoudness = 10.0;
+    static constexpr size_t numBins = size_t((maxHistogramLoudness - absoluteGate) / binWidth);
+
+    using FilterState = std::array<double, 4>;
+
+    static double toLoudness(double meanSquare) noexcept
+    {
+        return -0.691 + 10.0 * std::log10(meanSquare);
+    }
+
+    static float toReading(double meanSquare) noexcept
+    {
+        return meanSquare > 0.0 ? float(juce::jmax(double(minLoudness), toLoudness(meanSquare))) : minLoudness;
+    }
+
+    /** The BS.1770 filters, derived from their analog prototypes so any sample rate works. */
+    void designKWeighting(double sampleRate) noexcept
+    {
+        {
+            const auto gain = 3.999843853973347;
+            const auto quality = 0.7071752369554196;
+            const auto k = std::tan(juce::MathConstants<double>::pi * 1681.974450955533 / sampleRate);
+            const auto vh = std::pow(10.0, gain / 20.0);
+            const auto vb = std::pow(vh, 0.4996667741545416);
+            const auto a0 = 1.0 + k / quality + k * k;
+            _shelf = { (vh + vb * k / quality + k * k) / a0,
+                       2.0 * (k * k - vh) / a0,
+                       (vh - vb * k / quality + k * k) / a0,
+                       2.0 * (k * k - 1.0) / a0,
+                       (1.0 - k / quality + k * k) / a0 };
+        }
+        {
+            const auto quality = 0.5003270373238773;
+            const auto k = std::tan(juce::MathConstants<double>::pi * 38.13547087602444 / sampleRate);
+            const auto a0 = 1.0 + k / quality + k * k;
+            _highPass = { 1.0, -2.0, 1.0,
+                          2.0 * (k * k - 1.0) / a0,
+                          (1.0 - k / quality + k * k) / a0 };
+        }
+    }
+
+    /** Moves numSamples further into the current step, closing it when it is full. */
+    void advance(size_t numSamples) noexcept
+    {
+        _stepPosition += numSamples;
+        if (_stepPosition < _stepLength)
+            return;
+
+        _steps[_stepIndex] = _stepEnergy / double(_stepLength);
+        _stepIndex = (_stepIndex + 1) % numShortTermSteps;
+        _numSteps = juce::jmin(_numSteps + 1, numShortTermSteps);
+        _stepEnergy = 0.0;
+        _stepPosition = 0;
+
+        const auto momentary = getWindow(numMomentarySteps);
+        const auto shortTerm = getWindow(numShortTermSteps);
+
+        if (_resetRequested.exchange(false))
+            clearHistogram();
+
+        // Every step completes a 400 ms gating block overlapping the last one by 75 %.
+        if (_numSteps >= numMomentarySteps)
+            addBlock(momentary);
+
+        publish(momentary, shortTerm);
+    }
+
+    /** Returns the mean square over the last numWindowSteps steps. */
+    double getWindow(size_t numWindowSteps) const noexcept
+    {
+        auto sum = 0.0;
+        for (size_t i = 1; i <= numWindowSteps; ++i)
+            sum += _steps[(_stepIndex + numShortTermSteps - i) % numShortTermSteps];
+        return sum / double(numWindowSteps);
+    }
+
+    void addBlock(double meanSquare) noexcept
+    {
+        if (meanSquare <= 0.0)
+            return;
+
+        const auto loudness = toLoudness(meanSquare);
+        if (loudness < absoluteGate)
+            return;
+
+        const auto bin = juce::jmin(numBins - 1, size_t((loudness - absoluteGate) / binWidth));
+        ++_binCounts[bin];
+        _binEnergies[bin] += meanSquare;
+        ++_numGated;
+        _gatedEnergy += meanSquare;
+
+        // The relative gate, at the first bin edge at or above it.
+        const auto threshold = toLoudness(_gatedEnergy / double(_numGated)) + relativeGate;
+        const auto firstBin = threshold <= absoluteGate ? size_t(0)
+                            : juce::jmin(numBins, size_t(std::ceil((threshold - absoluteGate) / binWidth)));
+        juce::uint64 count = 0;
+        auto energy = 0.0;
+        for (auto b = firstBin; b < numBins; ++b)
+        {
+            count += _binCounts[b];
+            energy += _binEnergies[b];
+        }
+        _integratedMeanSquare = count > 0 ? energy / double(count) : 0.0;
+    }
+
+    void clearHistogram() noexcept
+    {
+        _binCounts.fill(0);
+        _binEnergies.fill(0.0);
+        _numGated = 0;
+        _gatedEnergy = 0.0;
+        _integratedMeanSquare = 0.0;
+    }
+
+    void publish(double momentary, double shortTerm) noexcept
+    {
+        _momentary.store(toReading(momentary), std::memory_order_relaxed);
+        _shortTerm.store(toReading(shortTerm), std::memory_order_relaxed);
+        _integrated.store(toReading(_integratedMeanSquare), std::memory_order_relaxed);
+    }
+
+    size_t _numChannels = 0;
+    std::vector<FilterState> _states;
+    std::vector<double> _weights;
+    std::array<double, 5> _shelf{};       // b0, b1, b2, a1, a2
+    std::array<double, 5> _highPass{};
+
+    size_t _stepLength = 4800;
+    size_t _stepPosition = 0;
+    double _stepEnergy = 0.0;
+    std::array<double, numShortTermSteps> _steps{};
+    size_t _stepIndex = 0;
+    size_t _numSteps = 0;
+
+    std::array<juce::uint64, numBins> _binCounts{};
+    std::array<double, numBins> _binEnergies{};
+    juce::uint64 _numGated = 0;
+    double _gatedEnergy = 0.0;
+    double _integratedMeanSquare = 0.0;
+
+    std::atomic<bool> _resetRequested{ false };
+    std::atomic<float> _momentary{ minLoudness };
+    std::atomic<float> _shortTerm{ minLoudness };
+    std::atomic<float> _integrated{ minLoudness };
+
+    JUCE_DECLARE_NON_COPYABLE(LoudnessMeter)
+};
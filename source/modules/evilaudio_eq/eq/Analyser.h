@@ -6,9 +6,24 @@ template<typename Type>
 class Analyser : public juce::Thread
 {
 public:
+    /** How the spectrum is analysed. A larger FFT resolves lower frequencies but costs more and reacts later. */
+    struct Settings
+    {
+        int   order = 12;           ///< FFT size as a power of two, from minOrder to maxOrder.
+        float overlap = 0.5f;       ///< Share of a frame analysed again in the next one, from 0 to maxOverlap.
+        typename juce::dsp::WindowingFunction<Type>::WindowingMethod window = juce::dsp::WindowingFunction<Type>::hann;
+        float averagingSeconds = 0.17f;     ///< How long the displayed spectrum is averaged over.
+    };
+
+    static constexpr int minOrder = 9;
+    static constexpr int maxOrder = 15;
+    static constexpr float maxOverlap = 0.875f;
+    static constexpr int maxAveragedFrames = 64;
+    static constexpr int pollMilliseconds = 10;     ///< How often the analyser thread looks for new audio.
+
     Analyser() : juce::Thread("Equaliser-Analyser")
     {
-        averager.clear();
+        applySettings();
     }
 
     ~Analyser() override = default;
@@ -30,54 +45,118 @@ public:
             if (block2 > 0) audioFifo.addFrom(0, start2, buffer.getReadPointer(channel, block1), block2);
         }
         abstractFifo.finishedWrite(block1 + block2);
-        waitForData.signal();
+    }
+
+    /** Sums the channels of a buffer with a different sample type into the analyser, converting on the way. */
+    template <typename OtherType>
+    void addAudioData(const juce::AudioBuffer<OtherType>& buffer, int startChannel, int numChannels)
+    {
+        if (abstractFifo.getFreeSpace() < buffer.getNumSamples())
+            return;
+
+        int start1, block1, start2, block2;
+        abstractFifo.prepareToWrite(buffer.getNumSamples(), start1, block1, start2, block2);
+
+        auto convert = [&](int fifoStart, int bufferStart, int numSamples)
+        {
+            auto* dest = audioFifo.getWritePointer(0, fifoStart);
+            std::fill(dest, dest + numSamples, Type(0));
+            for (int channel = startChannel; channel < startChannel + numChannels; ++channel)
+            {
+                const auto* source = buffer.getReadPointer(channel, bufferStart);
+                for (int i = 0; i < numSamples; ++i)
+                    dest[i] += Type(source[i]);
+            }
+        };
+
+        if (block1 > 0) convert(start1, 0, block1);
+        if (block2 > 0) convert(start2, block1, block2);
+
+        abstractFifo.finishedWrite(block1 + block2);
     }
 
     void setupAnalyser(int audioFifoSize, Type sampleRateToUse)
     {
+        // The FIFO holds at least two of the largest frames, whatever the settings become.
+        audioFifoSize = juce::jmax(audioFifoSize, 2 << maxOrder);
         sampleRate = sampleRateToUse;
         audioFifo.setSize(1, audioFifoSize);
         abstractFifo.setTotalSize(audioFifoSize);
+
+        // The number of averaged frames follows the sample rate.
+        settingsChanged = true;
         startThread(juce::Thread::Priority::normal);
     }
 
+    /**
+     *  Changes the analysis. The FFT and its buffers are reallocated on the analyser thread
+     *  before the next frame, so this never waits for an analysis and must not be called
+     *  from the audio thread. A running capture starts again, as its bins change.
+     */
+    void setSettings(const Settings& newSettings)
+    {
+        {
+            juce::ScopedLock lockedForSettings(settingsLock);
+            pendingSettings = newSettings;
+        }
+        settingsChanged = true;
+        waitForData.signal();
+    }
+
+    Settings getSettings() const
+    {
+        juce::ScopedLock lockedForSettings(settingsLock);
+        return pendingSettings;
+    }
+
     void run() override
     {
         while (!threadShouldExit())
         {
-            if (abstractFifo.getNumReady() >= fft.getSize())
+            if (settingsChanged)
+                applySettings();
+
+            const auto fftSize = fft->getSize();
+            if (abstractFifo.getNumReady() >= fftSize)
             {
                 fftBuffer.clear();
 
                 int start1, block1, start2, block2;
-                abstractFifo.prepareToRead(fft.getSize(), start1, block1, start2, block2);
+                abstractFifo.prepareToRead(fftSize, start1, block1, start2, block2);
                 if (block1 > 0) fftBuffer.copyFrom(0, 0, audioFifo.getReadPointer(0, start1), block1);
                 if (block2 > 0) fftBuffer.copyFrom(0, block1, audioFifo.getReadPointer(0, start2), block2);
-                abstractFifo.finishedRead((block1 + block2) / 2);
-
-                windowing.multiplyWithWindowingTable(fftBuffer.getWritePointer(0), size_t(fft.getSize()));
-                fft.performFrequencyOnlyForwardTransform(fftBuffer.getWritePointer(0));
+                abstractFifo.finishedRead(juce::jmin(hopSize, block1 + block2));
 
-                juce::ScopedLock lockedForWriting(pathCreationLock);
-                averager.addFrom(0, 0, averager.getReadPointer(averagerPtr), averager.getNumSamples(), -1.0f);
-                averager.copyFrom(averagerPtr, 0, fftBuffer.getReadPointer(0), averager.getNumSamples(), 1.0f / (averager.getNumSamples() * (averager.getNumChannels() - 1)));
-                averager.addFrom(0, 0, averager.getReadPointer(averagerPtr), averager.getNumSamples());
-                if (++averagerPtr == averager.getNumChannels()) averagerPtr = 1;
+                // A silent frame has a silent spectrum, so the transform is skipped, and once
+                // every averaged frame is silent the display has nothing new to show either.
+                auto* frame = fftBuffer.getWritePointer(0);
+                const auto range = juce::FloatVectorOperations::findMinAndMax(frame, fftSize);
+                const auto silent = juce::jmax(-range.getStart(), range.getEnd()) < silenceThreshold;
+                silentFrames = silent ? silentFrames + 1 : 0;
 
-                newDataAvailable = true;
+                if (silentFrames <= averager.getNumChannels() - 1)
+                {
+                    if (!silent)
+                    {
+                        windowing->multiplyWithWindowingTable(frame, size_t(fftSize));
+                        fft->performFrequencyOnlyForwardTransform(frame);
+                    }
+                    addToAverage(frame, silent);
+                }
             }
 
-            if (abstractFifo.getNumReady() < fft.getSize())
-                waitForData.wait(100);
+            // Polled rather than signalled, as signalling locks and addAudioData() runs on the audio thread.
+            if (abstractFifo.getNumReady() < fft->getSize())
+                waitForData.wait(pollMilliseconds);
         }
     }
 
     void createPath(juce::Path& p, const juce::Rectangle<float> bounds, float minFreq)
     {
+        juce::ScopedLock lockedForReading(pathCreationLock);
         p.clear();
         p.preallocateSpace(8 + averager.getNumSamples() * 3);
 
-        juce::ScopedLock lockedForReading(pathCreationLock);
         const auto* fftData = averager.getReadPointer(0);
         const auto  factor = bounds.getWidth() / 10.0f;
 
@@ -86,6 +165,53 @@ public:
             p.lineTo(bounds.getX() + factor * indexToX(float(i), minFreq), binToY(fftData[i], bounds));
     }
 
+    /** Starts averaging the power spectrum of everything added from now on, see getAverageSpectrum(). */
+    void startCapture()
+    {
+        juce::ScopedLock lockedForWriting(pathCreationLock);
+        capture.assign(size_t(fft->getSize() / 2 + 1), 0.0);
+        capturedFrames = 0;
+        capturing = true;
+    }
+
+    void stopCapture()
+    {
+        juce::ScopedLock lockedForWriting(pathCreationLock);
+        capturing = false;
+    }
+
+    /**
+     *  Returns the long term average spectrum since startCapture(), as log2 of the magnitude
+     *  at each of the frequencies, averaged over a band of smoothingOctaves around each.
+     *  The scale is arbitrary but the same for every capture.
+     *
+     *  @return false if nothing was captured yet.
+     */
+    bool getAverageSpectrum(const std::vector<double>& frequencies, double smoothingOctaves, std::vector<double>& spectrum)
+    {
+        juce::ScopedLock lockedForReading(pathCreationLock);
+        if (capturedFrames == 0)
+            return false;
+
+        spectrum.resize(frequencies.size());
+        const auto binsPerHertz = fft->getSize() / double(sampleRate);
+        const auto halfWidth = std::exp2(0.5 * smoothingOctaves);
+        const auto lastBin = int(capture.size()) - 1;
+        for (size_t i = 0; i < frequencies.size(); ++i)
+        {
+            // At least one bin, so the low end is not left empty where bands are narrower than bins.
+            const auto first = juce::jlimit(1, lastBin, int(std::floor(frequencies[i] / halfWidth * binsPerHertz)));
+            const auto last = juce::jlimit(first, lastBin, int(std::ceil(frequencies[i] * halfWidth * binsPerHertz)));
+
+            auto power = 0.0;
+            for (int bin = first; bin <= last; ++bin)
+                power += capture[size_t(bin)];
+            power /= double(last - first + 1) * double(capturedFrames);
+            spectrum[i] = 0.5 * std::log2(power + 1.0e-30);
+        }
+        return true;
+    }
+
     bool checkForNewData()
     {
         auto available = newDataAvailable.load();
@@ -94,9 +220,62 @@ public:
     }
 
 private:
+    /** Takes over the pending settings, allocating everything before the analysis is locked out. */
+    void applySettings()
+    {
+        settingsChanged = false;
+        const auto newSettings = getSettings();
+
+        auto newFFT = std::make_unique<juce::dsp::FFT>(juce::jlimit(minOrder, maxOrder, newSettings.order));
+        const auto fftSize = newFFT->getSize();
+        auto newWindowing = std::make_unique<juce::dsp::WindowingFunction<Type>>(size_t(fftSize), newSettings.window, true);
+        const auto newHopSize = juce::jmax(1, juce::roundToInt(fftSize * (1.0f - juce::jlimit(0.0f, maxOverlap, newSettings.overlap))));
+        const auto numFrames = juce::jlimit(1, maxAveragedFrames,
+            juce::roundToInt(newSettings.averagingSeconds * float(sampleRate) / float(newHopSize)));
+
+        juce::ScopedLock lockedForWriting(pathCreationLock);
+        fft = std::move(newFFT);
+        windowing = std::move(newWindowing);
+        hopSize = newHopSize;
+        fftBuffer.setSize(1, fftSize * 2);
+        averager.setSize(numFrames + 1, fftSize / 2);
+        averager.clear();
+        averagerPtr = 1;
+        silentFrames = 0;
+        if (capturing)
+        {
+            capture.assign(size_t(fftSize / 2 + 1), 0.0);
+            capturedFrames = 0;
+        }
+        newDataAvailable = true;
+    }
+
+    /** Replaces the oldest frame of the average with a spectrum, and adds it to a running capture. */
+    void addToAverage(const float* magnitudes, bool silent)
+    {
+        juce::ScopedLock lockedForWriting(pathCreationLock);
+        averager.addFrom(0, 0, averager.getReadPointer(averagerPtr), averager.getNumSamples(), -1.0f);
+        if (silent)
+            averager.clear(averagerPtr, 0, averager.getNumSamples());
+        else
+            averager.copyFrom(averagerPtr, 0, magnitudes, averager.getNumSamples(), 1.0f / (averager.getNumSamples() * (averager.getNumChannels() - 1)));
+        averager.addFrom(0, 0, averager.getReadPointer(averagerPtr), averager.getNumSamples());
+        if (++averagerPtr == averager.getNumChannels()) averagerPtr = 1;
+
+        // Pauses are left out of the long term average rather than pulling it down.
+        if (capturing && !silent)
+        {
+            for (size_t bin = 0; bin < capture.size(); ++bin)
+                capture[bin] += double(magnitudes[bin]) * double(magnitudes[bin]);
+            ++capturedFrames;
+        }
+
+        newDataAvailable = true;
+    }
+
     inline float indexToX(float index, float minFreq) const
     {
-        const auto freq = (sampleRate * index) / fft.getSize();
+        const auto freq = (sampleRate * index) / fft->getSize();
         return (freq > 0.01f) ? std::log(freq / minFreq) / std::log(2.0f) : 0.0f;
     }
 
@@ -110,14 +289,25 @@ private:
     juce::WaitableEvent waitForData;
     juce::CriticalSection pathCreationLock;
     Type sampleRate{};
-    juce::dsp::FFT fft{ 12 };
-    juce::dsp::WindowingFunction<Type> windowing{ size_t(fft.getSize()), juce::dsp::WindowingFunction<Type>::hann, true };
-    juce::AudioBuffer<float> fftBuffer{ 1, fft.getSize() * 2 };
-    juce::AudioBuffer<float> averager{ 5, fft.getSize() / 2 };
+    juce::CriticalSection settingsLock;
+    Settings pendingSettings;
+    std::atomic<bool> settingsChanged{ false };
+
+    // Only reallocated by applySettings(), under pathCreationLock.
+    std::unique_ptr<juce::dsp::FFT> fft;
+    std::unique_ptr<juce::dsp::WindowingFunction<Type>> windowing;
+    juce::AudioBuffer<float> fftBuffer;
+    juce::AudioBuffer<float> averager;
     int averagerPtr = 1;
+    int hopSize = 1;
+    int silentFrames = 0;
+    static constexpr float silenceThreshold = 1.0e-6f;  // -120 dB
     juce::AbstractFifo abstractFifo{ 48000 };
     juce::AudioBuffer<Type> audioFifo;
     std::atomic<bool> newDataAvailable;
+    std::vector<double> capture;
+    juce::int64 capturedFrames = 0;
+    bool capturing = false;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Analyser)
 };
@@ -0,0 +1,142 @@
+#pragma once
+
+#include "BiquadCoefficients.h"
+
+/**
+ *  RBJ biquad designs through the bilinear transform, without touching the heap.
+ *
+ *  These give the same coefficients as the juce::dsp::IIR::Coefficients factories of the
+ *  same name, but return a plain BiquadCoefficients instead of a reference counted object,
+ *  so they can be used on the audio thread, e.g. to follow the gain of a dynamic band once
+ *  per block or to apply sample accurate automation. Frequencies are in Hz and gains are
+ *  linear factors.
+ */
+struct BilinearBiquadDesign
+{
+    static BiquadCoefficients makeLowPass(double sampleRate, double frequency, double Q) noexcept
+    {
+        const auto n = 1.0 / std::tan(juce::MathConstants<double>::pi * frequency / sampleRate);
+        const auto nSquared = n * n;
+        const auto invQ = 1.0 / Q;
+        const auto c1 = 1.0 / (1.0 + invQ * n + nSquared);
+
+        return { c1, c1 * 2.0, c1, c1 * 2.0 * (1.0 - nSquared), c1 * (1.0 - invQ * n + nSquared) };
+    }
+
+    static BiquadCoefficients makeHighPass(double sampleRate, double frequency, double Q) noexcept
+    {
+        const auto n = std::tan(juce::MathConstants<double>::pi * frequency / sampleRate);
+        const auto nSquared = n * n;
+        const auto invQ = 1.0 / Q;
+        const auto c1 = 1.0 / (1.0 + invQ * n + nSquared);
+
+        return { c1, c1 * -2.0, c1, c1 * 2.0 * (nSquared - 1.0), c1 * (1.0 - invQ * n + nSquared) };
+    }
+
+    static BiquadCoefficients makeBandPass(double sampleRate, double frequency, double Q) noexcept
+    {
+        const auto n = 1.0 / std::tan(juce::MathConstants<double>::pi * frequency / sampleRate);
+        const auto nSquared = n * n;
+        const auto invQ = 1.0 / Q;
+        const auto c1 = 1.0 / (1.0 + invQ * n + nSquared);
+
+        return { c1 * n * invQ, 0.0, -c1 * n * invQ, c1 * 2.0 * (1.0 - nSquared), c1 * (1.0 - invQ * n + nSquared) };
+    }
+
+    static BiquadCoefficients makeNotch(double sampleRate, double frequency, double Q) noexcept
+    {
+        const auto n = 1.0 / std::tan(juce::MathConstants<double>::pi * frequency / sampleRate);
+        const auto nSquared = n * n;
+        const auto invQ = 1.0 / Q;
+        const auto c1 = 1.0 / (1.0 + invQ * n + nSquared);
+        const auto b0 = c1 * (1.0 + nSquared);
+        const auto b1 = 2.0 * c1 * (1.0 - nSquared);
+
+        return { b0, b1, b0, b1, c1 * (1.0 - n * invQ + nSquared) };
+    }
+
+    static BiquadCoefficients makeAllPass(double sampleRate, double frequency, double Q) noexcept
+    {
+        const auto n = 1.0 / std::tan(juce::MathConstants<double>::pi * frequency / sampleRate);
+        const auto nSquared = n * n;
+        const auto invQ = 1.0 / Q;
+        const auto c1 = 1.0 / (1.0 + invQ * n + nSquared);
+        const auto b0 = c1 * (1.0 - n * invQ + nSquared);
+        const auto b1 = c1 * 2.0 * (1.0 - nSquared);
+
+        return { b0, b1, 1.0, b1, b0 };
+    }
+
+    static BiquadCoefficients makePeakFilter(double sampleRate, double frequency, double Q, double gain) noexcept
+    {
+        const auto A = std::sqrt(juce::jmax(0.0, gain));
+        const auto omega = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+        const auto alpha = std::sin(omega) / (Q * 2.0);
+        const auto c2 = -2.0 * std::cos(omega);
+        const auto alphaTimesA = alpha * A;
+        const auto alphaOverA = alpha / A;
+
+        return normalise(1.0 + alphaTimesA, c2, 1.0 - alphaTimesA, 1.0 + alphaOverA, c2, 1.0 - alphaOverA);
+    }
+
+    static BiquadCoefficients makeLowShelf(double sampleRate, double frequency, double Q, double gain) noexcept
+    {
+        const auto A = std::sqrt(juce::jmax(0.0, gain));
+        const auto aminus1 = A - 1.0;
+        const auto aplus1 = A + 1.0;
+        const auto omega = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+        const auto coso = std::cos(omega);
+        const auto beta = std::sin(omega) * std::sqrt(A) / Q;
+        const auto aminus1TimesCoso = aminus1 * coso;
+
+        return normalise(A * (aplus1 - aminus1TimesCoso + beta),
+                         A * 2.0 * (aminus1 - aplus1 * coso),
+                         A * (aplus1 - aminus1TimesCoso - beta),
+                         aplus1 + aminus1TimesCoso + beta,
+                         -2.0 * (aminus1 + aplus1 * coso),
+                         aplus1 + aminus1TimesCoso - beta);
+    }
+
+    static BiquadCoefficients makeHighShelf(double sampleRate, double frequency, double Q, double gain) noexcept
+    {
+        const auto A = std::sqrt(juce::jmax(0.0, gain));
+        const auto aminus1 = A - 1.0;
+        const auto aplus1 = A + 1.0;
+        const auto omega = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+        const auto coso = std::cos(omega);
+        const auto beta = std::sin(omega) * std::sqrt(A) / Q;
+        const auto aminus1TimesCoso = aminus1 * coso;
+
+        return normalise(A * (aplus1 + aminus1TimesCoso + beta),
+                         A * -2.0 * (aminus1 + aplus1 * coso),
+                         A * (aplus1 + aminus1TimesCoso - beta),
+                         aplus1 - aminus1TimesCoso + beta,
+                         2.0 * (aminus1 - aplus1 * coso),
+                         aplus1 - aminus1TimesCoso - beta);
+    }
+
+    static BiquadCoefficients makeFirstOrderLowPass(double sampleRate, double frequency) noexcept
+    {
+        const auto n = std::tan(juce::MathConstants<double>::pi * frequency / sampleRate);
+        return normalise(n, n, 0.0, n + 1.0, n - 1.0, 0.0);
+    }
+
+    static BiquadCoefficients makeFirstOrderHighPass(double sampleRate, double frequency) noexcept
+    {
+        const auto n = std::tan(juce::MathConstants<double>::pi * frequency / sampleRate);
+        return normalise(1.0, -1.0, 0.0, n + 1.0, n - 1.0, 0.0);
+    }
+
+    static BiquadCoefficients makeFirstOrderAllPass(double sampleRate, double frequency) noexcept
+    {
+        const auto n = std::tan(juce::MathConstants<double>::pi * frequency / sampleRate);
+        return normalise(n - 1.0, n + 1.0, 0.0, n + 1.0, n - 1.0, 0.0);
+    }
+
+private:
+    static BiquadCoefficients normalise(double b0, double b1, double b2, double a0, double a1, double a2) noexcept
+    {
+        const auto scale = 1.0 / a0;
+        return { b0 * scale, b1 * scale, b2 * scale, a1 * scale, a2 * scale };
+    }
+};
@@ -0,0 +1,586 @@
+#pragma once
+
+#include "juce_dsp/juce_dsp.h"
+#include "BiquadCoefficients.h"
+
+/**
+ *  Complete description of a cascade, as handed from the designer to the audio thread.
+ */
+struct BiquadCascadeSettings
+{
+    /**
+     *  The channels of each left/right pair of the bus layout a section filters, such as
+     *  the front, surround or height pairs. Mid and Side run on the mid/side encoded pair.
+     *  Channels without a partner (centre, LFE, ambisonic or discrete channels) have no
+     *  sides, so they take every section as if it were Stereo.
+     */
+    enum Routing
+    {
+        Stereo = 0,
+        Left,
+        Right,
+        Mid,
+        Side
+    };
+
+    static constexpr size_t maxNumSections = 32;
+
+    std::array<BiquadCoefficients, maxNumSections> sections{};
+    std::array<bool, maxNumSections> enabled{};
+    std::array<Routing, maxNumSections> routing{};
+};
+
+/**
+ *  Series of second order sections processed in a single pass per sample.
+ *
+ *  Coefficients and filter states are kept in struct-of-arrays form, and channels are
+ *  packed into the lanes of a juce::dsp::SIMDRegister, so a stereo or quad buffer is
+ *  rendered with one walk over the samples and eight channels with two. Channels left
+ *  over after the full groups share one last, partly filled group: with four lanes a
+ *  5.1 bus takes two walks and a 7.1.4 bus three, rather than a pass per channel. Only
+ *  enabled sections are visited: the cascade keeps a compacted list of them, and sections
+ *  that enter or leave that list are faded in from (or out to) a unity section by ramping
+ *  their coefficients, which also smooths ordinary coefficient changes.
+ *
+ *  Each section has its own coefficients per lane, so sections routed to the left or right
+ *  channel of a pair cost the same as stereo ones. The pairs come from the channel types of
+ *  the bus layout, not from the channel order: a 5.1 bus pairs L/R and Ls/Rs and leaves
+ *  C and LFE unpaired. Pairs take adjacent lanes first, the unpaired channels the lanes
+ *  after them, where every section runs as a stereo one. Sections routed to mid or side run on
+ *  a mid/side encoded copy of each pair, after the sections on left and right; the
+ *  encoding is done while interleaving, so a cascade with only mid/side (and stereo)
+ *  sections still takes a single pass. Stereo sections run in whichever domain the other
+ *  sections need, which does not change their result.
+ *
+ *  Each section uses the same transposed direct form II recursion as
+ *  juce::dsp::IIR::Filter, so the output matches a chain of those filters to within
+ *  floating point rounding (about 1e-6 relative for float).
+ */
+template <typename SampleType>
+class BiquadCascade
+{
+public:
+    using Vector = juce::dsp::SIMDRegister<SampleType>;
+    using Routing = BiquadCascadeSettings::Routing;
+
+    static constexpr size_t maxNumSections = BiquadCascadeSettings::maxNumSections;
+    static constexpr size_t numLanes = Vector::SIMDNumElements;
+    static_assert(numLanes % 2 == 0, "the pairs of channels must not straddle two groups");
+
+    BiquadCascade()
+    {
+        for (size_t i = 0; i < maxNumSections; ++i)
+        {
+            setVectors(_b0, _b1, _b2, _a1, _a2, i, {}, BiquadCascadeSettings::Stereo);
+            setVectors(_t0, _t1, _t2, _ta1, _ta2, i, {}, BiquadCascadeSettings::Stereo);
+        }
+    }
+
+    /** Allocates for the default layout of JUCE with spec.numChannels channels, see prepare(spec, layout). */
+    void prepare(const juce::dsp::ProcessSpec& spec)
+    {
+        prepare(spec, juce::AudioChannelSet::canonicalChannelSet(int(spec.numChannels)));
+    }
+
+    /**
+     *  Allocates the per channel state and the interleaving scratch space, and pairs up the
+     *  left and right channels of the layout for the routed sections. Channels past the end
+     *  of the layout are unpaired. process() expects blocks with spec.numChannels channels.
+     */
+    void prepare(const juce::dsp::ProcessSpec& spec, const juce::AudioChannelSet& layout)
+    {
+        _numChannels = size_t(spec.numChannels);
+        _numGroups = (_numChannels + numLanes - 1) / numLanes;
+        assignLanes(layout);
+
+        _state1.assign(_numGroups * maxNumSections, Vector::expand(SampleType(0)));
+        _state2.assign(_numGroups * maxNumSections, Vector::expand(SampleType(0)));
+        _scratch.assign(juce::jmax(size_t(1), size_t(spec.maximumBlockSize)), Vector::expand(SampleType(0)));
+
+        setRampLength(size_t(juce::jmax(1, juce::roundToInt(spec.sampleRate * defaultRampSeconds))));
+    }
+
+    /** Clears the filter states and jumps to the current target coefficients. */
+    void reset() noexcept
+    {
+        std::fill(_state1.begin(), _state1.end(), Vector::expand(SampleType(0)));
+        std::fill(_state2.begin(), _state2.end(), Vector::expand(SampleType(0)));
+
+        if (_rampRemaining > 0)
+        {
+            _rampRemaining = 0;
+            finishRamp();
+        }
+    }
+
+    /** Sets the number of samples over which coefficient changes are interpolated. */
+    void setRampLength(size_t numSamples) noexcept
+    {
+        _rampLength = juce::jmax(size_t(1), numSamples);
+    }
+
+    /**
+     *  Takes over new target coefficients and rebuilds the list of sections to run.
+     *
+     *  Sections that become enabled start from unity with cleared state, sections that
+     *  become disabled keep running until they have faded to unity. A section that moves
+     *  between the left/right and the mid/side domain starts again from unity, unless it
+     *  is a stereo section, whose state carries over.
+     */
+    void setSettings(const BiquadCascadeSettings& settings) noexcept
+    {
+        setSettings(settings, _rampLength);
+    }
+
+    /**
+     *  Takes over new target coefficients, ramping to them over rampLength samples instead
+     *  of the length set with setRampLength(). Used to follow coefficients that change on
+     *  every block, such as those of dynamic bands, by interpolating over each block.
+     */
+    void setSettings(const BiquadCascadeSettings& settings, size_t rampLength) noexcept
+    {
+        rampLength = juce::jmax(size_t(1), rampLength);
+        const auto rampScale = SampleType(1) / SampleType(rampLength);
+
+        // Stereo sections join the mid/side pass when that saves the left/right one.
+        auto hasLeftRight = false, hasMidSide = false;
+        for (size_t i = 0; i < maxNumSections; ++i)
+        {
+            if (!settings.enabled[i])
+                continue;
+            hasLeftRight = hasLeftRight || isLeftRight(settings.routing[i]);
+            hasMidSide = hasMidSide || isMidSide(settings.routing[i]);
+        }
+        const auto stereoInMidSide = hasMidSide && !hasLeftRight;
+
+        _numActive = 0;
+        for (size_t i = 0; i < maxNumSections; ++i)
+        {
+            const auto wasRunning = _running[i];
+            _wanted[i] = settings.enabled[i];
+            _running[i] = wasRunning || _wanted[i];
+
+            // Sections that fade out keep the routing and the domain they had.
+            if (_wanted[i])
+            {
+                const auto routing = settings.routing[i];
+                const auto midSide = isMidSide(routing) || (routing == BiquadCascadeSettings::Stereo && stereoInMidSide);
+
+                if (wasRunning && midSide != _midSide[i])
+                {
+                    if (routing == BiquadCascadeSettings::Stereo && _routing[i] == BiquadCascadeSettings::Stereo)
+                    {
+                        convertState(i, midSide);
+                    }
+                    else
+                    {
+                        setVectors(_b0, _b1, _b2, _a1, _a2, i, {}, BiquadCascadeSettings::Stereo);
+                        clearState(i);
+                    }
+                }
+                _routing[i] = routing;
+                _midSide[i] = midSide;
+            }
+
+            setVectors(_t0, _t1, _t2, _ta1, _ta2, i, _wanted[i] ? settings.sections[i] : BiquadCoefficients{}, _routing[i]);
+
+            if (!_running[i])
+                continue;
+
+            if (!wasRunning)
+                clearState(i);
+
+            _d0[i] = (_t0[i] - _b0[i]) * rampScale;
+            _d1[i] = (_t1[i] - _b1[i]) * rampScale;
+            _d2[i] = (_t2[i] - _b2[i]) * rampScale;
+            _da1[i] = (_ta1[i] - _a1[i]) * rampScale;
+            _da2[i] = (_ta2[i] - _a2[i]) * rampScale;
+
+            _active[_numActive++] = i;
+        }
+        splitActiveSections();
+        _rampRemaining = rampLength;
+    }
+
+    /** Returns the number of sections that are currently run, including ones fading out. */
+    size_t getNumActiveSections() const noexcept
+    {
+        return _numActive;
+    }
+
+    void process(const juce::dsp::ProcessContextReplacing<SampleType>& context) noexcept
+    {
+        auto& block = context.getOutputBlock();
+        const auto numSamples = block.getNumSamples();
+
+        if (context.isBypassed || _numActive == 0 || numSamples == 0)
+            return;
+
+        // The lanes are assigned to the channels of the prepared layout, which must all be there.
+        jassert(!_scratch.empty());
+        jassert(size_t(block.getNumChannels()) >= _numChannels);
+        if (size_t(block.getNumChannels()) < _numChannels)
+            return;
+
+        for (size_t offset = 0; offset < numSamples; offset += _scratch.size())
+        {
+            const auto numToDo = juce::jmin(_scratch.size(), numSamples - offset);
+            const auto numRampSamples = juce::jmin(numToDo, _rampRemaining);
+
+            for (size_t group = 0; group < _numGroups; ++group)
+            {
+                const auto firstLane = group * numLanes;
+                const auto numGroupChannels = juce::jmin(numLanes, _numChannels - firstLane);
+                const auto numPairedLanes = getNumPairedLanes(group);
+
+                // Encode while interleaving when there is nothing to run on left and right.
+                const auto encodeFirst = _numLeftRight == 0;
+                interleave(block, firstLane, numGroupChannels, numPairedLanes, offset, numToDo, encodeFirst);
+                processGroup(group, _activeLeftRight, _numLeftRight, numPairedLanes, numToDo, numRampSamples);
+
+                if (_numMidSide > 0)
+                {
+                    if (!encodeFirst)
+                        encodeMidSide(numPairedLanes, numToDo);
+                    processGroup(group, _activeMidSide, _numMidSide, numPairedLanes, numToDo, numRampSamples);
+                }
+                deinterleave(block, firstLane, numGroupChannels, numPairedLanes, offset, numToDo, _numMidSide > 0);
+            }
+
+            advanceRamp(numRampSamples);
+        }
+    }
+
+private:
+    static bool isLeftRight(Routing routing) noexcept
+    {
+        return routing == BiquadCascadeSettings::Left || routing == BiquadCascadeSettings::Right;
+    }
+
+    static bool isMidSide(Routing routing) noexcept
+    {
+        return routing == BiquadCascadeSettings::Mid || routing == BiquadCascadeSettings::Side;
+    }
+
+    /**
+     *  Gives the left and right channel of each pair of the layout an even and the following
+     *  odd lane, where the routed sections expect them, and the unpaired channels the lanes
+     *  after all pairs.
+     */
+    void assignLanes(const juce::AudioChannelSet& layout)
+    {
+        using Type = juce::AudioChannelSet::ChannelType;
+        static constexpr std::pair<Type, Type> pairs[] = {
+            { juce::AudioChannelSet::left,              juce::AudioChannelSet::right },
+            { juce::AudioChannelSet::leftCentre,        juce::AudioChannelSet::rightCentre },
+            { juce::AudioChannelSet::leftSurround,      juce::AudioChannelSet::rightSurround },
+            { juce::AudioChannelSet::leftSurroundSide,  juce::AudioChannelSet::rightSurroundSide },
+            { juce::AudioChannelSet::leftSurroundRear,  juce::AudioChannelSet::rightSurroundRear },
+            { juce::AudioChannelSet::wideLeft,          juce::AudioChannelSet::wideRight },
+            { juce::AudioChannelSet::topFrontLeft,      juce::AudioChannelSet::topFrontRight },
+            { juce::AudioChannelSet::topSideLeft,       juce::AudioChannelSet::topSideRight },
+            { juce::AudioChannelSet::topRearLeft,       juce::AudioChannelSet::topRearRight }
+        };
+
+        std::vector<bool> paired(_numChannels, false);
+        _laneChannels.clear();
+        _laneChannels.reserve(_numChannels);
+
+        for (size_t channel = 0; channel < _numChannels && int(channel) < layout.size(); ++channel)
+        {
+            const auto type = layout.getTypeOfChannel(int(channel));
+            for (const auto& pair : pairs)
+            {
+                const auto partner = layout.getChannelIndexForType(pair.second);
+                if (type == pair.first && juce::isPositiveAndBelow(partner, _numChannels))
+                {
+                    _laneChannels.push_back(channel);
+                    _laneChannels.push_back(size_t(partner));
+                    paired[channel] = paired[size_t(partner)] = true;
+                }
+            }
+        }
+        _numPairedLanes = _laneChannels.size();
+
+        for (size_t channel = 0; channel < _numChannels; ++channel)
+            if (!paired[channel])
+                _laneChannels.push_back(channel);
+    }
+
+    /** Returns how many of the lanes of a group, from the first one, hold left/right pairs. */
+    size_t getNumPairedLanes(size_t group) const noexcept
+    {
+        const auto firstLane = group * numLanes;
+        return juce::jmin(numLanes, _numPairedLanes - juce::jmin(_numPairedLanes, firstLane));
+    }
+
+    /** Copies a group of channels into the lanes of the scratch space, mid/side encoding the pairs if asked to. */
+    void interleave(juce::dsp::AudioBlock<SampleType>& block, size_t firstLane, size_t numGroupChannels,
+                    size_t numPairedLanes, size_t offset, size_t numSamples, bool encode) noexcept
+    {
+        auto* raw = reinterpret_cast<SampleType*>(_scratch.data());
+
+        if (numGroupChannels < numLanes)
+            std::fill(raw, raw + numSamples * numLanes, SampleType(0));
+
+        size_t lane = 0;
+        for (; encode && lane < numPairedLanes; lane += 2)
+        {
+            const auto* left = block.getChannelPointer(_laneChannels[firstLane + lane]) + offset;
+            const auto* right = block.getChannelPointer(_laneChannels[firstLane + lane + 1]) + offset;
+            for (size_t i = 0; i < numSamples; ++i)
+            {
+                raw[i * numLanes + lane] = SampleType(0.5) * (left[i] + right[i]);
+                raw[i * numLanes + lane + 1] = SampleType(0.5) * (left[i] - right[i]);
+            }
+        }
+
+        for (; lane < numGroupChannels; ++lane)
+        {
+            const auto* source = block.getChannelPointer(_laneChannels[firstLane + lane]) + offset;
+            for (size_t i = 0; i < numSamples; ++i)
+                raw[i * numLanes + lane] = source[i];
+        }
+    }
+
+    /** Copies the lanes of the scratch space back to the channels, decoding the mid/side pairs if asked to. */
+    void deinterleave(juce::dsp::AudioBlock<SampleType>& block, size_t firstLane, size_t numGroupChannels,
+                      size_t numPairedLanes, size_t offset, size_t numSamples, bool decode) noexcept
+    {
+        const auto* raw = reinterpret_cast<const SampleType*>(_scratch.data());
+
+        size_t lane = 0;
+        for (; decode && lane < numPairedLanes; lane += 2)
+        {
+            auto* left = block.getChannelPointer(_laneChannels[firstLane + lane]) + offset;
+            auto* right = block.getChannelPointer(_laneChannels[firstLane + lane + 1]) + offset;
+            for (size_t i = 0; i < numSamples; ++i)
+            {
+                left[i] = raw[i * numLanes + lane] + raw[i * numLanes + lane + 1];
+                right[i] = raw[i * numLanes + lane] - raw[i * numLanes + lane + 1];
+            }
+        }
+
+        for (; lane < numGroupChannels; ++lane)
+        {
+            auto* dest = block.getChannelPointer(_laneChannels[firstLane + lane]) + offset;
+            for (size_t i = 0; i < numSamples; ++i)
+                dest[i] = raw[i * numLanes + lane];
+        }
+    }
+
+    /** Mid/side encodes the pairs in the scratch space, between the left/right and the mid/side pass. */
+    void encodeMidSide(size_t numPairedLanes, size_t numSamples) noexcept
+    {
+        auto* raw = reinterpret_cast<SampleType*>(_scratch.data());
+
+        for (size_t i = 0; i < numSamples; ++i)
+        {
+            for (size_t lane = 0; lane < numPairedLanes; lane += 2)
+            {
+                const auto left = raw[i * numLanes + lane];
+                const auto right = raw[i * numLanes + lane + 1];
+                raw[i * numLanes + lane] = SampleType(0.5) * (left + right);
+                raw[i * numLanes + lane + 1] = SampleType(0.5) * (left - right);
+            }
+        }
+    }
+
+    void processGroup(size_t group, const std::array<size_t, maxNumSections>& active, size_t numActive,
+                      size_t numPairedLanes, size_t numSamples, size_t numRampSamples) noexcept
+    {
+        if (numActive == 0)
+            return;
+
+        // Local, compacted copies of the coefficients and increments, so that every channel
+        // group follows the same trajectory while a ramp is in progress.
+        std::array<Vector, maxNumSections> b0, b1, b2, a1, a2;
+        std::array<Vector, maxNumSections> d0, d1, d2, da1, da2;
+        for (size_t k = 0; k < numActive; ++k)
+        {
+            const auto s = active[k];
+            b0[k] = _b0[s]; b1[k] = _b1[s]; b2[k] = _b2[s]; a1[k] = _a1[s]; a2[k] = _a2[s];
+            d0[k] = _d0[s]; d1[k] = _d1[s]; d2[k] = _d2[s]; da1[k] = _da1[s]; da2[k] = _da2[s];
+
+            // Unpaired lanes run routed sections as stereo ones, with the values of the side they are routed to.
+            if (numPairedLanes < numLanes && _routing[s] != BiquadCascadeSettings::Stereo)
+            {
+                const auto routedLane = getFirstRoutedLane(_routing[s]);
+                for (auto* vector : { &b0[k], &b1[k], &b2[k], &a1[k], &a2[k], &d0[k], &d1[k], &d2[k], &da1[k], &da2[k] })
+                {
+                    const auto value = vector->get(routedLane);
+                    for (auto lane = numPairedLanes; lane < numLanes; ++lane)
+                        vector->set(lane, value);
+                }
+            }
+        }
+
+        auto* state1 = _state1.data() + group * maxNumSections;
+        auto* state2 = _state2.data() + group * maxNumSections;
+
+        auto tick = [&](Vector x) noexcept
+        {
+            for (size_t k = 0; k < numActive; ++k)
+            {
+                const auto s = active[k];
+                const auto y = (b0[k] * x) + state1[s];
+                state1[s] = (b1[k] * x) - (a1[k] * y) + state2[s];
+                state2[s] = (b2[k] * x) - (a2[k] * y);
+                x = y;
+            }
+            return x;
+        };
+
+        size_t i = 0;
+        for (; i < numRampSamples; ++i)
+        {
+            _scratch[i] = tick(_scratch[i]);
+
+            for (size_t k = 0; k < numActive; ++k)
+            {
+                b0[k] += d0[k]; b1[k] += d1[k]; b2[k] += d2[k]; a1[k] += da1[k]; a2[k] += da2[k];
+            }
+        }
+
+        for (; i < numSamples; ++i)
+            _scratch[i] = tick(_scratch[i]);
+    }
+
+    void advanceRamp(size_t numSamples) noexcept
+    {
+        if (numSamples == 0)
+            return;
+
+        _rampRemaining -= numSamples;
+        if (_rampRemaining == 0)
+        {
+            finishRamp();
+            return;
+        }
+
+        const auto steps = SampleType(numSamples);
+        for (size_t k = 0; k < _numActive; ++k)
+        {
+            const auto s = _active[k];
+            _b0[s] += _d0[s] * steps; _b1[s] += _d1[s] * steps; _b2[s] += _d2[s] * steps;
+            _a1[s] += _da1[s] * steps; _a2[s] += _da2[s] * steps;
+        }
+    }
+
+    /** Lands exactly on the targets and drops the sections that have faded out. */
+    void finishRamp() noexcept
+    {
+        size_t numKept = 0;
+        for (size_t k = 0; k < _numActive; ++k)
+        {
+            const auto s = _active[k];
+            _b0[s] = _t0[s]; _b1[s] = _t1[s]; _b2[s] = _t2[s]; _a1[s] = _ta1[s]; _a2[s] = _ta2[s];
+            _running[s] = _wanted[s];
+
+            if (_running[s])
+                _active[numKept++] = s;
+        }
+        _numActive = numKept;
+        splitActiveSections();
+    }
+
+    /** Sorts the running sections into the left/right and the mid/side pass, keeping their order. */
+    void splitActiveSections() noexcept
+    {
+        _numLeftRight = 0;
+        _numMidSide = 0;
+        for (size_t k = 0; k < _numActive; ++k)
+        {
+            const auto s = _active[k];
+            if (_midSide[s])
+                _activeMidSide[_numMidSide++] = s;
+            else
+                _activeLeftRight[_numLeftRight++] = s;
+        }
+    }
+
+    /** Carries the state of a stereo section over to the other domain, which is exact as both lanes of a pair run the same filter. */
+    void convertState(size_t section, bool toMidSide) noexcept
+    {
+        const auto scale = toMidSide ? SampleType(0.5) : SampleType(1);
+        for (size_t group = 0; group < _numGroups; ++group)
+        {
+            const auto numPairedLanes = getNumPairedLanes(group);
+            for (auto* state : { &_state1[group * maxNumSections + section], &_state2[group * maxNumSections + section] })
+            {
+                for (size_t lane = 0; lane < numPairedLanes; lane += 2)
+                {
+                    const auto first = state->get(lane);
+                    const auto second = state->get(lane + 1);
+                    state->set(lane, scale * (first + second));
+                    state->set(lane + 1, scale * (first - second));
+                }
+            }
+        }
+    }
+
+    void clearState(size_t section) noexcept
+    {
+        for (size_t group = 0; group < _numGroups; ++group)
+        {
+            _state1[group * maxNumSections + section] = Vector::expand(SampleType(0));
+            _state2[group * maxNumSections + section] = Vector::expand(SampleType(0));
+        }
+    }
+
+    using VectorArray = std::array<Vector, maxNumSections>;
+
+    static void setVectors(VectorArray& b0, VectorArray& b1, VectorArray& b2, VectorArray& a1, VectorArray& a2,
+                           size_t section, const BiquadCoefficients& coefficients, Routing routing) noexcept
+    {
+        jassert(section < maxNumSections);
+        b0[section] = makeVector(coefficients.b0, 1.0, routing);
+        b1[section] = makeVector(coefficients.b1, 0.0, routing);
+        b2[section] = makeVector(coefficients.b2, 0.0, routing);
+        a1[section] = makeVector(coefficients.a1, 0.0, routing);
+        a2[section] = makeVector(coefficients.a2, 0.0, routing);
+    }
+
+    /** Puts a coefficient into the lanes a section is routed to, and the unity value into the others. */
+    static Vector makeVector(double coefficient, double unity, Routing routing) noexcept
+    {
+        if (routing == BiquadCascadeSettings::Stereo)
+            return Vector::expand(SampleType(coefficient));
+
+        auto result = Vector::expand(SampleType(unity));
+        for (auto lane = getFirstRoutedLane(routing); lane < numLanes; lane += 2)
+            result.set(lane, SampleType(coefficient));
+        return result;
+    }
+
+    /** Left and mid take the even lanes of the pairs, right and side the odd ones. */
+    static size_t getFirstRoutedLane(Routing routing) noexcept
+    {
+        return (routing == BiquadCascadeSettings::Left || routing == BiquadCascadeSettings::Mid) ? size_t(0) : size_t(1);
+    }
+
+    static constexpr double defaultRampSeconds = 0.005;
+
+    // Current coefficients, ramp targets and per sample increments.
+    VectorArray _b0, _b1, _b2, _a1, _a2;
+    VectorArray _t0, _t1, _t2, _ta1, _ta2;
+    VectorArray _d0, _d1, _d2, _da1, _da2;
+    std::array<bool, maxNumSections> _running{}, _wanted{};
+    std::array<Routing, maxNumSections> _routing{};
+    std::array<bool, maxNumSections> _midSide{};
+    std::array<size_t, maxNumSections> _active{}, _activeLeftRight{}, _activeMidSide{};
+    size_t _numActive = 0;
+    size_t _numLeftRight = 0;
+    size_t _numMidSide = 0;
+    size_t _rampLength = 1;
+    size_t _rampRemaining = 0;
+
+    size_t _numChannels = 0;
+    size_t _numGroups = 0;
+    std::vector<size_t> _laneChannels;
+    size_t _numPairedLanes = 0;
+    std::vector<Vector> _state1, _state2;
+    std::vector<Vector> _scratch;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BiquadCascade)
+};
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <limits>
+
+#include "juce_dsp/juce_dsp.h"
+
+/**
+ *  Plain, normalised (a0 == 1) second order section.
+ *
+ *  First order designs are stored with b2 == a2 == 0 so that every band has the
+ *  same layout and can be copied around without touching the heap. Coefficients are
+ *  kept in double precision and only rounded when a float cascade takes them over.
+ */
+struct BiquadCoefficients
+{
+    double b0 = 1.0;
+    double b1 = 0.0;
+    double b2 = 0.0;
+    double a1 = 0.0;
+    double a2 = 0.0;
+
+    /** Converts a JUCE design (first or second order) into the fixed layout. */
+    template <typename NumericType>
+    static BiquadCoefficients fromJuceCoefficients(const juce::dsp::IIR::Coefficients<NumericType>& source)
+    {
+        BiquadCoefficients result;
+        const auto* raw = source.coefficients.begin();
+
+        switch (source.getFilterOrder())
+        {
+            case 1:
+                result = { double(raw[0]), double(raw[1]), 0.0, double(raw[2]), 0.0 };
+                break;
+            case 2:
+                result = { double(raw[0]), double(raw[1]), double(raw[2]), double(raw[3]), double(raw[4]) };
+                break;
+            default:
+                jassertfalse;
+                break;
+        }
+        return result;
+    }
+
+    /**
+     *  Returns the magnitude response at a frequency in Hz.
+     *
+     *  Uses |b0 + b1 z^-1 + b2 z^-2|^2 = (b0 + b1 + b2)^2 cos^2(w/2) + (b0 - b1 + b2)^2 sin^2(w/2)
+     *  - 4 b0 b2 sin^2(w), and the same for the denominator, which stays accurate for
+     *  low frequencies where the complex evaluation loses precision.
+     */
+    double getMagnitudeForFrequency(double frequency, double sampleRate) const noexcept
+    {
+        const auto s = std::sin(juce::MathConstants<double>::pi * frequency / sampleRate);
+        const auto phi1 = s * s;
+        const auto phi0 = 1.0 - phi1;
+        const auto phi2 = 4.0 * phi0 * phi1;
+
+        const auto numerator = juce::square(b0 + b1 + b2) * phi0 + juce::square(b0 - b1 + b2) * phi1 - 4.0 * b0 * b2 * phi2;
+        const auto denominator = juce::square(1.0 + a1 + a2) * phi0 + juce::square(1.0 - a1 + a2) * phi1 - 4.0 * a2 * phi2;
+
+        return denominator > 0.0 ? std::sqrt(juce::jmax(0.0, numerator) / denominator) : 0.0;
+    }
+
+    /**
+     *  Returns the number of samples the impulse response needs to fall by a factor (e.g.
+     *  1.0e-6 for 120 dB), from the radius of the slowest pole. Sections without feedback
+     *  settle after two samples, unstable ones never.
+     */
+    double getDecayLength(double factor) const noexcept
+    {
+        const auto discriminant = a1 * a1 - 4.0 * a2;
+        const auto radius = discriminant < 0.0 ? std::sqrt(a2) : 0.5 * (std::abs(a1) + std::sqrt(discriminant));
+
+        if (radius >= 1.0)
+            return std::numeric_limits<double>::infinity();
+        if (radius <= 0.0)
+            return 2.0;
+        return juce::jmax(2.0, std::log(factor) / std::log(radius));
+    }
+};
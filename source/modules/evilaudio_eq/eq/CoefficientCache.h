@@ -0,0 +1,199 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <vector>
+
+#include <juce_core/juce_core.h>
+#include "BiquadCoefficients.h"
+
+/**
+ *  Bounded cache of band designs and their response curves.
+ *
+ *  Dragging a band around or automating it keeps revisiting the same positions, and each
+ *  visit would otherwise design the band and evaluate its response curve again. Entries
+ *  are keyed on the filter type, the design mode, the sample rate, and frequency, Q and
+ *  gain quantised to steps that are well below what can be heard. Callers design from the
+ *  quantised values (see getFrequency() and friends), so what a key holds never depends
+ *  on which value first filled its slot.
+ *
+ *  The cache is set associative: a key can only live in one of the few slots of its set,
+ *  and the least recently used of them is replaced. A lookup costs a hash and a handful of
+ *  compares, and the memory stays bounded however long a session runs.
+ *
+ *  @note Only one thread may call find() and insert(); the statistics can be read from any
+ *        thread, e.g. to tune the quantisation while dragging.
+ */
+class CoefficientCache
+{
+public:
+    /** Quantisation steps. Frequency and Q are ratios, so they are quantised in cents. */
+    struct Quantisation
+    {
+        double frequencyCents = 1.0;
+        double qualityCents = 1.0;
+        double gainDecibels = 0.01;
+    };
+
+    struct Key
+    {
+        int type = -1;
+        int mode = 0;
+        double sampleRate = 0.0;
+        int frequency = 0;
+        int quality = 0;
+        int gain = 0;
+
+        bool operator==(const Key& other) const noexcept
+        {
+            return type == other.type && mode == other.mode && sampleRate == other.sampleRate
+                && frequency == other.frequency && quality == other.quality && gain == other.gain;
+        }
+    };
+
+    struct Entry
+    {
+        Key key;
+        bool valid = false;
+        juce::uint32 lastUse = 0;
+        BiquadCoefficients coefficients;
+        std::vector<double> response;
+    };
+
+    struct Statistics
+    {
+        juce::uint64 hits = 0;
+        juce::uint64 misses = 0;
+    };
+
+    static constexpr size_t numSets = 16;
+    static constexpr size_t numWays = 4;
+
+    CoefficientCache() = default;
+
+    explicit CoefficientCache(const Quantisation& quantisationToUse)
+        : _quantisation(quantisationToUse)
+    {
+    }
+
+    /**
+     *  Sizes the response curves of all entries, so that filling an entry copies into
+     *  storage it already owns. Not for the thread that uses the cache.
+     */
+    void prepare(size_t numPoints)
+    {
+        for (auto& entry : _entries)
+            entry.response.assign(numPoints, 0.0);
+    }
+
+    /**
+     *  Builds the key of a design. Parameters the filter type does not use should be
+     *  flagged, so that e.g. low passes with different gains share an entry.
+     */
+    Key makeKey(int type, int mode, double sampleRate, double frequency, double quality, double gain,
+                bool usesQuality, bool usesGain) const noexcept
+    {
+        Key key;
+        key.type = type;
+        key.mode = mode;
+        key.sampleRate = sampleRate;
+        key.frequency = quantise(1200.0 * std::log2(juce::jmax(1.0e-3, frequency)), _quantisation.frequencyCents);
+        key.quality = usesQuality ? quantise(1200.0 * std::log2(juce::jmax(1.0e-3, quality)), _quantisation.qualityCents) : 0;
+        key.gain = usesGain ? quantise(juce::Decibels::gainToDecibels(gain, -200.0), _quantisation.gainDecibels) : 0;
+        return key;
+    }
+
+    /** Returns the frequency a key was quantised to, in Hz. */
+    double getFrequency(const Key& key) const noexcept
+    {
+        return std::exp2(key.frequency * _quantisation.frequencyCents / 1200.0);
+    }
+
+    /** Returns the Q a key was quantised to. */
+    double getQuality(const Key& key) const noexcept
+    {
+        return std::exp2(key.quality * _quantisation.qualityCents / 1200.0);
+    }
+
+    /** Returns the gain a key was quantised to, as a linear factor. */
+    double getGain(const Key& key) const noexcept
+    {
+        return juce::Decibels::decibelsToGain(key.gain * _quantisation.gainDecibels, -200.0);
+    }
+
+    /** Returns the entry for a key, or nullptr if it has to be designed and inserted. */
+    const Entry* find(const Key& key) noexcept
+    {
+        auto* set = getSet(key);
+        for (size_t way = 0; way < numWays; ++way)
+        {
+            auto& entry = set[way];
+            if (entry.valid && entry.key == key)
+            {
+                entry.lastUse = ++_useCounter;
+                _hits.fetch_add(1, std::memory_order_relaxed);
+                return &entry;
+            }
+        }
+        _misses.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    /** Makes room for a key and returns its entry, to be filled in by the caller. */
+    Entry& insert(const Key& key) noexcept
+    {
+        auto* set = getSet(key);
+        auto* victim = &set[0];
+        for (size_t way = 0; way < numWays && victim->valid; ++way)
+            if (!set[way].valid || set[way].lastUse < victim->lastUse)
+                victim = &set[way];
+
+        victim->key = key;
+        victim->valid = true;
+        victim->lastUse = ++_useCounter;
+        return *victim;
+    }
+
+    /** Drops all entries, keeping the statistics. */
+    void clear() noexcept
+    {
+        for (auto& entry : _entries)
+            entry.valid = false;
+    }
+
+    Statistics getStatistics() const noexcept
+    {
+        return { _hits.load(std::memory_order_relaxed), _misses.load(std::memory_order_relaxed) };
+    }
+
+    void resetStatistics() noexcept
+    {
+        _hits = 0;
+        _misses = 0;
+    }
+
+private:
+    static int quantise(double value, double step) noexcept
+    {
+        return juce::roundToInt(value / step);
+    }
+
+    Entry* getSet(const Key& key) noexcept
+    {
+        // Mixes the fields in the order of how often they change during a drag.
+        auto hash = juce::uint32(key.frequency) * 0x9e3779b1u;
+        hash = (hash ^ juce::uint32(key.gain)) * 0x85ebca6bu;
+        hash = (hash ^ juce::uint32(key.quality)) * 0xc2b2ae35u;
+        hash ^= juce::uint32(key.type) | (juce::uint32(key.mode) << 8);
+        hash ^= hash >> 16;
+        return &_entries[(hash % numSets) * numWays];
+    }
+
+    Quantisation _quantisation;
+    std::array<Entry, numSets * numWays> _entries;
+    juce::uint32 _useCounter = 0;
+    std::atomic<juce::uint64> _hits{ 0 };
+    std::atomic<juce::uint64> _misses{ 0 };
+
+    JUCE_DECLARE_NON_COPYABLE(CoefficientCache)
+};
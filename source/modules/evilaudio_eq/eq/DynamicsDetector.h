@@ -0,0 +1,215 @@
+#pragma once
+
+#include "juce_dsp/juce_dsp.h"
+#include "BiquadCascade.h"
+
+/**
+ *  Level detectors for the dynamic bands of the equaliser.
+ *
+ *  Each detector band limits the key signal with its own second order section and follows
+ *  the rectified result with a peak envelope that has separate attack and release times.
+ *  As in BiquadCascade, channels are packed into the lanes of a juce::dsp::SIMDRegister and
+ *  all requested detectors are run in one walk over the samples, so a detector costs about
+ *  as much as a cascade section. The attack/release choice is made without branches, by
+ *  splitting the difference to the envelope into its rising and falling parts.
+ *
+ *  Levels are read once per block with getLevel(), which returns the loudest channel, so
+ *  all channels of a band are driven by the same gain.
+ */
+template <typename SampleType>
+class DynamicsDetector
+{
+public:
+    using Vector = juce::dsp::SIMDRegister<SampleType>;
+
+    static constexpr size_t maxNumDetectors = BiquadCascadeSettings::maxNumSections;
+    static constexpr size_t numLanes = Vector::SIMDNumElements;
+
+    DynamicsDetector()
+    {
+        for (size_t i = 0; i < maxNumDetectors; ++i)
+            setDetector(i, {}, 0.0, 0.0);
+    }
+
+    /** Allocates the per channel state and the interleaving scratch space. */
+    void prepare(const juce::dsp::ProcessSpec& spec)
+    {
+        _sampleRate = spec.sampleRate;
+        _numChannels = size_t(spec.numChannels);
+        _numGroups = (_numChannels + numLanes - 1) / numLanes;
+
+        _state1.assign(_numGroups * maxNumDetectors, Vector::expand(SampleType(0)));
+        _state2.assign(_numGroups * maxNumDetectors, Vector::expand(SampleType(0)));
+        _envelopes.assign(_numGroups * maxNumDetectors, Vector::expand(SampleType(0)));
+        _scratch.assign(juce::jmax(size_t(1), size_t(spec.maximumBlockSize)), Vector::expand(SampleType(0)));
+        _levels.fill(SampleType(0));
+    }
+
+    /** Clears the key filters and the envelopes of all detectors. */
+    void reset() noexcept
+    {
+        for (size_t i = 0; i < maxNumDetectors; ++i)
+            clearDetector(i);
+    }
+
+    /** Clears the key filter and the envelope of one detector, e.g. when it starts to be used. */
+    void clearDetector(size_t index) noexcept
+    {
+        jassert(index < maxNumDetectors);
+        for (size_t group = 0; group < _numGroups; ++group)
+        {
+            _state1[group * maxNumDetectors + index] = Vector::expand(SampleType(0));
+            _state2[group * maxNumDetectors + index] = Vector::expand(SampleType(0));
+            _envelopes[group * maxNumDetectors + index] = Vector::expand(SampleType(0));
+        }
+        _levels[index] = SampleType(0);
+    }
+
+    /**
+     *  Sets the key filter and the ballistics of a detector, keeping its state.
+     *
+     *  The times are in seconds to get within 1 / e of a new level, 0 follows immediately.
+     */
+    void setDetector(size_t index, const BiquadCoefficients& keyFilter, double attackSeconds, double releaseSeconds) noexcept
+    {
+        jassert(index < maxNumDetectors);
+        _b0[index] = Vector::expand(SampleType(keyFilter.b0));
+        _b1[index] = Vector::expand(SampleType(keyFilter.b1));
+        _b2[index] = Vector::expand(SampleType(keyFilter.b2));
+        _a1[index] = Vector::expand(SampleType(keyFilter.a1));
+        _a2[index] = Vector::expand(SampleType(keyFilter.a2));
+        _attack[index] = Vector::expand(SampleType(getCoefficient(attackSeconds)));
+        _release[index] = Vector::expand(SampleType(getCoefficient(releaseSeconds)));
+    }
+
+    /**
+     *  Runs the detectors whose bits are set in mask over a block of the key signal.
+     *
+     *  Channels beyond the prepared channel count are ignored.
+     */
+    void process(const juce::dsp::AudioBlock<SampleType>& key, juce::uint32 mask) noexcept
+    {
+        const auto numChannels = juce::jmin(_numChannels, size_t(key.getNumChannels()));
+        const auto numSamples = key.getNumSamples();
+
+        size_t numActive = 0;
+        for (size_t i = 0; i < maxNumDetectors; ++i)
+            if ((mask & (juce::uint32(1) << i)) != 0)
+                _active[numActive++] = i;
+
+        if (numActive == 0 || numChannels == 0)
+            return;
+
+        for (size_t offset = 0; offset < numSamples; offset += _scratch.size())
+        {
+            const auto numToDo = juce::jmin(_scratch.size(), numSamples - offset);
+
+            for (size_t group = 0; group < _numGroups; ++group)
+            {
+                const auto firstChannel = group * numLanes;
+                const auto numGroupChannels = juce::jmin(numLanes, numChannels - juce::jmin(numChannels, firstChannel));
+
+                if (numGroupChannels == 0)
+                    break;
+
+                interleave(key, firstChannel, numGroupChannels, offset, numToDo);
+                processGroup(group, numActive, numToDo);
+            }
+        }
+
+        for (size_t k = 0; k < numActive; ++k)
+        {
+            const auto d = _active[k];
+            auto level = SampleType(0);
+            for (size_t group = 0; group < _numGroups; ++group)
+            {
+                const auto& envelope = _envelopes[group * maxNumDetectors + d];
+                for (size_t lane = 0; lane < numLanes; ++lane)
+                    level = juce::jmax(level, envelope.get(lane));
+            }
+            _levels[d] = level;
+        }
+    }
+
+    /** Returns the envelope of a detector at the end of the last block, of the loudest channel. */
+    SampleType getLevel(size_t index) const noexcept
+    {
+        jassert(index < maxNumDetectors);
+        return _levels[index];
+    }
+
+private:
+    double getCoefficient(double seconds) const noexcept
+    {
+        // The share of the distance to the input that the envelope covers per sample.
+        if (seconds <= 0.0 || _sampleRate <= 0.0)
+            return 1.0;
+        return 1.0 - std::exp(-1.0 / (seconds * _sampleRate));
+    }
+
+    void interleave(const juce::dsp::AudioBlock<SampleType>& block, size_t firstChannel, size_t numGroupChannels,
+                    size_t offset, size_t numSamples) noexcept
+    {
+        auto* raw = reinterpret_cast<SampleType*>(_scratch.data());
+
+        if (numGroupChannels < numLanes)
+            std::fill(raw, raw + numSamples * numLanes, SampleType(0));
+
+        for (size_t lane = 0; lane < numGroupChannels; ++lane)
+        {
+            const auto* source = block.getChannelPointer(firstChannel + lane) + offset;
+            for (size_t i = 0; i < numSamples; ++i)
+                raw[i * numLanes + lane] = source[i];
+        }
+    }
+
+    void processGroup(size_t group, size_t numActive, size_t numSamples) noexcept
+    {
+        // Compacted local copies, the detectors are independent and all read the same key.
+        std::array<Vector, maxNumDetectors> b0, b1, b2, a1, a2, attack, release, state1, state2, envelope;
+        for (size_t k = 0; k < numActive; ++k)
+        {
+            const auto d = _active[k];
+            const auto s = group * maxNumDetectors + d;
+            b0[k] = _b0[d]; b1[k] = _b1[d]; b2[k] = _b2[d]; a1[k] = _a1[d]; a2[k] = _a2[d];
+            attack[k] = _attack[d]; release[k] = _release[d];
+            state1[k] = _state1[s]; state2[k] = _state2[s]; envelope[k] = _envelopes[s];
+        }
+
+        const auto zero = Vector::expand(SampleType(0));
+        for (size_t i = 0; i < numSamples; ++i)
+        {
+            const auto x = _scratch[i];
+            for (size_t k = 0; k < numActive; ++k)
+            {
+                const auto y = (b0[k] * x) + state1[k];
+                state1[k] = (b1[k] * x) - (a1[k] * y) + state2[k];
+                state2[k] = (b2[k] * x) - (a2[k] * y);
+
+                const auto difference = Vector::abs(y) - envelope[k];
+                envelope[k] += (attack[k] * Vector::max(difference, zero)) + (release[k] * Vector::min(difference, zero));
+            }
+        }
+
+        for (size_t k = 0; k < numActive; ++k)
+        {
+            const auto s = group * maxNumDetectors + _active[k];
+            _state1[s] = state1[k]; _state2[s] = state2[k]; _envelopes[s] = envelope[k];
+        }
+    }
+
+    using VectorArray = std::array<Vector, maxNumDetectors>;
+
+    VectorArray _b0, _b1, _b2, _a1, _a2;
+    VectorArray _attack, _release;
+    std::array<size_t, maxNumDetectors> _active{};
+    std::array<SampleType, maxNumDetectors> _levels{};
+
+    double _sampleRate = 0.0;
+    size_t _numChannels = 0;
+    size_t _numGroups = 0;
+    std::vector<Vector> _state1, _state2, _envelopes;
+    std::vector<Vector> _scratch;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DynamicsDetector)
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+
+#include <juce_core/juce_core.h>
+
+/**
+ *  Wait-free single-producer / single-consumer exchange of the latest value.
+ *
+ *  The producer writes into a private slot and publishes it with a single atomic
+ *  exchange; the consumer picks up the most recently published slot with another
+ *  exchange. Neither side ever blocks or allocates, so the consumer may safely be
+ *  the audio thread. Intermediate values that the consumer never saw are dropped.
+ *
+ *  @note Exactly one thread may call the producer methods (getWriteBuffer, publish,
+ *        write) and exactly one thread may call the consumer methods (update,
+ *        getReadBuffer, read) at any one time.
+ */
+template <typename Type>
+class LockFreeTripleBuffer
+{
+public:
+    LockFreeTripleBuffer() = default;
+
+    /** Sets every slot to the same value. Only call this while neither side is running. */
+    void reset(const Type& value)
+    {
+        _buffers.fill(value);
+    }
+
+    /** Returns the slot owned by the producer. Fill it in, then call publish(). */
+    Type& getWriteBuffer() noexcept
+    {
+        return _buffers[size_t(_writeIndex)];
+    }
+
+    /** Hands the producer's slot over to the consumer. */
+    void publish() noexcept
+    {
+        _writeIndex = _shared.exchange(_writeIndex | newDataFlag, std::memory_order_acq_rel) & indexMask;
+    }
+
+    /** Convenience for copying a value into the producer's slot and publishing it. */
+    void write(const Type& value)
+    {
+        getWriteBuffer() = value;
+        publish();
+    }
+
+    /**
+     *  Swaps in the most recently published slot, if there is one.
+     *
+     *  @return true if getReadBuffer() now refers to a newly published value.
+     */
+    bool update() noexcept
+    {
+        if ((_shared.load(std::memory_order_acquire) & newDataFlag) == 0)
+            return false;
+
+        _readIndex = _shared.exchange(_readIndex, std::memory_order_acq_rel) & indexMask;
+        return true;
+    }
+
+    /** Returns the slot owned by the consumer. */
+    const Type& getReadBuffer() const noexcept
+    {
+        return _buffers[size_t(_readIndex)];
+    }
+
+    /** Copies the newest published value into dest, returning false if nothing new arrived. */
+    bool read(Type& dest)
+    {
+        if (!update())
+            return false;
+
+        dest = getReadBuffer();
+        return true;
+    }
+
+private:
+    static constexpr int indexMask = 3;
+    static constexpr int newDataFlag = 4;
+
+    std::array<Type, 3> _buffers{};
+    int _writeIndex = 0;
+    int _readIndex = 1;
+    std::atomic<int> _shared{ 2 };
+
+    JUCE_DECLARE_NON_COPYABLE(LockFreeTripleBuffer)
+};
@@ -0,0 +1,441 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "BilinearBiquadDesign.h"
+#include "MatchedBiquadDesign.h"
+#include "ResponseEvaluator.h"
+
+/**
+ *  Fits bands of peaks and shelves to a difference curve, for the match EQ.
+ *
+ *  The curve is log2 of the magnitude on the plot frequencies, like the band responses, so
+ *  the response of the bands is the sum of their curves and a band parameter only moves
+ *  its own curve. The fit is a Levenberg-Marquardt least squares over the frequency, Q
+ *  (both on a log scale) and log2 gain of every band, with a forward difference Jacobian
+ *  that only evaluates the band a column belongs to. A light penalty on the gains keeps
+ *  neighbouring bands from cancelling each other out with large opposing boosts.
+ *
+ *  Least squares finds the nearest minimum, so fit() starts from one of numLayouts
+ *  layouts: with or without shelves at either end, and broad or narrow peaks placed
+ *  greedily on the largest deviations. The layouts are independent of each other and are
+ *  meant to run on a thread pool, keeping the result with the lowest error.
+ */
+class MatchFitter
+{
+public:
+    enum Shape
+    {
+        LowShelf = 0,
+        Peak,
+        HighShelf
+    };
+
+    struct Band
+    {
+        Shape  shape = Peak;
+        double frequency = 1000.0;
+        double quality = 0.71;
+        double gain = 1.0;          ///< Linear, as the band designs take it.
+    };
+
+    struct Problem
+    {
+        std::vector<double> frequencies;
+        std::vector<double> target;     ///< log2 of the magnitude to fit at each frequency.
+        std::vector<double> weights;    ///< Weight of each frequency, 0 to leave it out.
+        double sampleRate = 48000.0;
+        bool   matched = false;         ///< Use MatchedBiquadDesign instead of the bilinear designs.
+        size_t numBands = 6;
+    };
+
+    struct Result
+    {
+        std::vector<Band> bands;        ///< Sorted by frequency.
+        double error = std::numeric_limits<double>::infinity();    ///< Weighted RMS error in dB.
+    };
+
+    static constexpr int numLayouts = 8;
+    static constexpr double maxGainDecibels = 24.0;
+
+    /** Fits the bands starting from a layout between 0 and numLayouts - 1. Safe to call from any thread. */
+    static Result fit(const Problem& problem, int layout)
+    {
+        Result result;
+        const auto lowShelf = (layout & 1) != 0;
+        const auto highShelf = (layout & 2) != 0;
+        const auto numShelves = size_t(lowShelf ? 1 : 0) + size_t(highShelf ? 1 : 0);
+        if (problem.numBands == 0 || numShelves > problem.numBands || problem.target.size() != problem.frequencies.size())
+            return result;
+
+        Solver solver(problem);
+        solver.initialise(lowShelf, highShelf, (layout & 4) != 0 ? 2.0 : 0.7);
+        solver.solve();
+
+        result.bands = solver.getBands();
+        std::sort(result.bands.begin(), result.bands.end(),
+                  [](const Band& a, const Band& b) { return a.frequency < b.frequency; });
+        result.error = solver.getError();
+        return result;
+    }
+
+    /** Designs a band with the same designs as the processor. */
+    static BiquadCoefficients design(const Band& band, double sampleRate, bool matched) noexcept
+    {
+        switch (band.shape)
+        {
+            case LowShelf:
+                return matched ? MatchedBiquadDesign::makeLowShelf(sampleRate, band.frequency, band.quality, band.gain)
+                               : BilinearBiquadDesign::makeLowShelf(sampleRate, band.frequency, band.quality, band.gain);
+            case HighShelf:
+                return matched ? MatchedBiquadDesign::makeHighShelf(sampleRate, band.frequency, band.quality, band.gain)
+                               : BilinearBiquadDesign::makeHighShelf(sampleRate, band.frequency, band.quality, band.gain);
+            case Peak:
+            default:
+                return matched ? MatchedBiquadDesign::makePeakFilter(sampleRate, band.frequency, band.quality, band.gain)
+                               : BilinearBiquadDesign::makePeakFilter(sampleRate, band.frequency, band.quality, band.gain);
+        }
+    }
+
+private:
+    static constexpr size_t numBandParameters = 3;  // log frequency, log Q, log2 gain
+    static constexpr int maxIterations = 50;
+    static constexpr double gainPenalty = 1.0e-3;
+    static constexpr double derivativeStep = 1.0e-4;
+
+    class Solver
+    {
+    public:
+        explicit Solver(const Problem& problem)
+            : _problem(problem),
+              _numPoints(problem.frequencies.size()),
+              _numBands(problem.numBands),
+              _numParameters(problem.numBands * numBandParameters)
+        {
+            _evaluator.prepare(problem.frequencies, problem.sampleRate);
+            _shapes.assign(_numBands, Peak);
+            _parameters.assign(_numParameters, 0.0);
+            _lower.assign(_numParameters, 0.0);
+            _upper.assign(_numParameters, 0.0);
+            _responses.assign(_numBands * _numPoints, 0.0);
+            _column.assign(_numPoints, 0.0);
+            _errors.assign(_numPoints, 0.0);
+            _jacobian.assign(_numParameters * _numPoints, 0.0);
+            _normal.assign(_numParameters * _numParameters, 0.0);
+            _gradient.assign(_numParameters, 0.0);
+            _step.assign(_numParameters, 0.0);
+
+            _weightSum = 0.0;
+            for (auto weight : problem.weights)
+                _weightSum += weight;
+        }
+
+        /** Places the shelves at the ends and the peaks one by one on the largest remaining deviation. */
+        void initialise(bool lowShelf, bool highShelf, double peakQuality)
+        {
+            std::vector<double> remaining(_problem.target);
+            size_t band = 0;
+
+            auto place = [&](Shape shape, double frequency, double quality, double logGain)
+            {
+                _shapes[band] = shape;
+                setBounds(band);
+                const auto offset = band * numBandParameters;
+                _parameters[offset] = juce::jlimit(_lower[offset], _upper[offset], std::log(frequency));
+                _parameters[offset + 1] = juce::jlimit(_lower[offset + 1], _upper[offset + 1], std::log(quality));
+                _parameters[offset + 2] = juce::jlimit(_lower[offset + 2], _upper[offset + 2], logGain);
+
+                auto* response = &_responses[band * _numPoints];
+                evaluate(band, &_parameters[offset], response);
+                for (size_t i = 0; i < _numPoints; ++i)
+                    remaining[i] -= response[i];
+                ++band;
+            };
+
+            if (lowShelf)
+                place(LowShelf, lowShelfFrequency, 0.71, getMeanBelow(remaining, lowShelfFrequency));
+            if (highShelf)
+                place(HighShelf, highShelfFrequency, 0.71, getMeanAbove(remaining, highShelfFrequency));
+
+            while (band < _numBands)
+            {
+                size_t largest = 0;
+                for (size_t i = 1; i < _numPoints; ++i)
+                    if (_problem.weights[i] * std::abs(remaining[i]) > _problem.weights[largest] * std::abs(remaining[largest]))
+                        largest = i;
+                place(Peak, _problem.frequencies[largest], peakQuality, remaining[largest]);
+            }
+
+            _cost = getCost(_parameters, _responses);
+        }
+
+        void solve()
+        {
+            auto lambda = 1.0e-3;
+            std::vector<double> trial(_numParameters);
+            std::vector<double> trialResponses(_responses.size());
+
+            for (int iteration = 0; iteration < maxIterations; ++iteration)
+            {
+                updateErrors(_responses);
+                updateJacobian();
+                updateNormalEquations();
+
+                auto improved = false;
+                for (int attempt = 0; attempt < 10 && !improved; ++attempt)
+                {
+                    if (!solveStep(lambda))
+                    {
+                        lambda *= 10.0;
+                        continue;
+                    }
+
+                    for (size_t p = 0; p < _numParameters; ++p)
+                        trial[p] = juce::jlimit(_lower[p], _upper[p], _parameters[p] + _step[p]);
+                    for (size_t band = 0; band < _numBands; ++band)
+                        evaluate(band, &trial[band * numBandParameters], &trialResponses[band * _numPoints]);
+
+                    const auto cost = getCost(trial, trialResponses);
+                    if (cost < _cost)
+                    {
+                        const auto converged = _cost - cost < 1.0e-6 * _cost;
+                        _parameters.swap(trial);
+                        _responses.swap(trialResponses);
+                        _cost = cost;
+                        lambda = juce::jmax(1.0e-9, lambda * 0.3);
+                        improved = !converged;
+                        if (converged)
+                            return;
+                    }
+                    else
+                    {
+                        lambda *= 10.0;
+                    }
+                }
+
+                if (!improved)
+                    return;
+            }
+        }
+
+        std::vector<Band> getBands() const
+        {
+            std::vector<Band> bands(_numBands);
+            for (size_t band = 0; band < _numBands; ++band)
+                bands[band] = toBand(band, &_parameters[band * numBandParameters]);
+            return bands;
+        }
+
+        double getError() const
+        {
+            // Without the penalty, as the RMS of the weighted deviation in dB.
+            std::vector<double> summed(_numPoints, 0.0);
+            for (size_t band = 0; band < _numBands; ++band)
+                for (size_t i = 0; i < _numPoints; ++i)
+                    summed[i] += _responses[band * _numPoints + i];
+
+            double squares = 0.0;
+            for (size_t i = 0; i < _numPoints; ++i)
+                squares += _problem.weights[i] * juce::square(summed[i] - _problem.target[i]);
+            return _weightSum > 0.0 ? decibelsPerLog2 * std::sqrt(squares / _weightSum) : 0.0;
+        }
+
+    private:
+        static constexpr double lowShelfFrequency = 120.0;
+        static constexpr double highShelfFrequency = 6000.0;
+        static constexpr double decibelsPerLog2 = 6.020599913279624;   // 20 log10(2)
+
+        void setBounds(size_t band)
+        {
+            const auto offset = band * numBandParameters;
+            const auto shelf = _shapes[band] != Peak;
+            const auto maxLogGain = maxGainDecibels / decibelsPerLog2;
+
+            _lower[offset] = std::log(20.0);
+            _upper[offset] = std::log(juce::jlimit(20.0, 20000.0, 0.45 * _problem.sampleRate));
+            _lower[offset + 1] = std::log(shelf ? 0.3 : 0.1);
+            _upper[offset + 1] = std::log(shelf ? 2.0 : 10.0);
+            _lower[offset + 2] = -maxLogGain;
+            _upper[offset + 2] = maxLogGain;
+        }
+
+        Band toBand(size_t band, const double* parameters) const noexcept
+        {
+            Band result;
+            result.shape = _shapes[band];
+            result.frequency = std::exp(parameters[0]);
+            result.quality = std::exp(parameters[1]);
+            result.gain = std::exp2(parameters[2]);
+            return result;
+        }
+
+        void evaluate(size_t band, const double* parameters, double* response)
+        {
+            _evaluator.process(design(toBand(band, parameters), _problem.sampleRate, _problem.matched), response);
+        }
+
+        double getCost(const std::vector<double>& parameters, const std::vector<double>& responses) const
+        {
+            double cost = 0.0;
+            for (size_t i = 0; i < _numPoints; ++i)
+            {
+                auto summed = -_problem.target[i];
+                for (size_t band = 0; band < _numBands; ++band)
+                    summed += responses[band * _numPoints + i];
+                cost += _problem.weights[i] * summed * summed;
+            }
+            for (size_t band = 0; band < _numBands; ++band)
+                cost += gainPenalty * juce::square(parameters[band * numBandParameters + 2]);
+            return cost;
+        }
+
+        void updateErrors(const std::vector<double>& responses)
+        {
+            for (size_t i = 0; i < _numPoints; ++i)
+            {
+                auto summed = -_problem.target[i];
+                for (size_t band = 0; band < _numBands; ++band)
+                    summed += responses[band * _numPoints + i];
+                _errors[i] = summed;
+            }
+        }
+
+        void updateJacobian()
+        {
+            std::array<double, numBandParameters> moved{};
+            for (size_t band = 0; band < _numBands; ++band)
+            {
+                const auto offset = band * numBandParameters;
+                const auto* response = &_responses[band * _numPoints];
+                for (size_t k = 0; k < numBandParameters; ++k)
+                {
+                    std::copy_n(&_parameters[offset], numBandParameters, moved.begin());
+
+                    // Step inwards at the upper bound, so the design stays within its range.
+                    const auto step = moved[k] + derivativeStep > _upper[offset + k] ? -derivativeStep : derivativeStep;
+                    moved[k] += step;
+                    evaluate(band, moved.data(), _column.data());
+
+                    auto* column = &_jacobian[(offset + k) * _numPoints];
+                    for (size_t i = 0; i < _numPoints; ++i)
+                        column[i] = (_column[i] - response[i]) / step;
+                }
+            }
+        }
+
+        /** Builds J^T W J and J^T W e, plus the gain penalty. */
+        void updateNormalEquations()
+        {
+            for (size_t p = 0; p < _numParameters; ++p)
+            {
+                const auto* a = &_jacobian[p * _numPoints];
+                double gradient = 0.0;
+                for (size_t i = 0; i < _numPoints; ++i)
+                    gradient += a[i] * _problem.weights[i] * _errors[i];
+                _gradient[p] = gradient;
+
+                for (size_t q = 0; q <= p; ++q)
+                {
+                    const auto* b = &_jacobian[q * _numPoints];
+                    double sum = 0.0;
+                    for (size_t i = 0; i < _numPoints; ++i)
+                        sum += a[i] * _problem.weights[i] * b[i];
+                    _normal[p * _numParameters + q] = sum;
+                    _normal[q * _numParameters + p] = sum;
+                }
+            }
+
+            for (size_t band = 0; band < _numBands; ++band)
+            {
+                const auto p = band * numBandParameters + 2;
+                _normal[p * _numParameters + p] += gainPenalty;
+                _gradient[p] += gainPenalty * _parameters[p];
+            }
+        }
+
+        /** Solves (A + lambda diag(A)) step = -gradient by a Cholesky decomposition, false if it is not positive definite. */
+        bool solveStep(double lambda)
+        {
+            const auto n = _numParameters;
+            _factor.assign(_normal.begin(), _normal.end());
+            for (size_t p = 0; p < n; ++p)
+                _factor[p * n + p] += lambda * _normal[p * n + p] + 1.0e-12;
+
+            for (size_t j = 0; j < n; ++j)
+            {
+                auto diagonal = _factor[j * n + j];
+                for (size_t k = 0; k < j; ++k)
+                    diagonal -= juce::square(_factor[j * n + k]);
+                if (!(diagonal > 0.0))
+                    return false;
+                diagonal = std::sqrt(diagonal);
+                _factor[j * n + j] = diagonal;
+
+                for (size_t i = j + 1; i < n; ++i)
+                {
+                    auto sum = _factor[i * n + j];
+                    for (size_t k = 0; k < j; ++k)
+                        sum -= _factor[i * n + k] * _factor[j * n + k];
+                    _factor[i * n + j] = sum / diagonal;
+                }
+            }
+
+            // L y = -gradient, then L^T step = y.
+            for (size_t i = 0; i < n; ++i)
+            {
+                auto sum = -_gradient[i];
+                for (size_t k = 0; k < i; ++k)
+                    sum -= _factor[i * n + k] * _step[k];
+                _step[i] = sum / _factor[i * n + i];
+            }
+            for (size_t i = n; i-- > 0;)
+            {
+                auto sum = _step[i];
+                for (size_t k = i + 1; k < n; ++k)
+                    sum -= _factor[k * n + i] * _step[k];
+                _step[i] = sum / _factor[i * n + i];
+            }
+            return true;
+        }
+
+        double getMeanBelow(const std::vector<double>& curve, double frequency) const
+        {
+            return getMean(curve, [frequency](double f) { return f <= frequency; });
+        }
+
+        double getMeanAbove(const std::vector<double>& curve, double frequency) const
+        {
+            return getMean(curve, [frequency](double f) { return f >= frequency; });
+        }
+
+        template <typename Predicate>
+        double getMean(const std::vector<double>& curve, Predicate include) const
+        {
+            double sum = 0.0, weights = 0.0;
+            for (size_t i = 0; i < _numPoints; ++i)
+            {
+                if (!include(_problem.frequencies[i]))
+                    continue;
+                sum += _problem.weights[i] * curve[i];
+                weights += _problem.weights[i];
+            }
+            return weights > 0.0 ? sum / weights : 0.0;
+        }
+
+        const Problem& _problem;
+        const size_t _numPoints, _numBands, _numParameters;
+        ResponseEvaluator _evaluator;
+        std::vector<Shape> _shapes;
+        std::vector<double> _parameters, _lower, _upper;
+        std::vector<double> _responses;     ///< Curve of each band, numPoints per band.
+        std::vector<double> _column, _errors;
+        std::vector<double> _jacobian;      ///< One column of numPoints per parameter.
+        std::vector<double> _normal, _factor, _gradient, _step;
+        double _weightSum = 0.0;
+        double _cost = 0.0;
+    };
+};
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+
+#include <juce_core/juce_core.h>
+
+/** A parameter change that takes effect at a sample offset into the next processed block. */
+struct ParameterEvent
+{
+    int parameterIndex = -1;    ///< As returned by juce::AudioProcessorParameter::getParameterIndex().
+    float value = 0.0f;         ///< Normalised to 0..1, like juce::AudioProcessorParameter::setValue().
+    int sampleOffset = 0;       ///< Position in the block, counted at the host rate.
+};
+
+/**
+ *  Wait-free single-producer / single-consumer queue of timestamped parameter events.
+ *
+ *  The producer (whoever knows where in the block automation points fall, e.g. a host's
+ *  playback engine) pushes events for the next block, the audio thread takes all of them
+ *  at once, sorted by their offset. Both sides work on a fixed ring and never allocate;
+ *  events that do not fit are rejected rather than delaying the audio thread.
+ *
+ *  @note Exactly one thread may call push() and exactly one thread may call popAll() or
+ *        clear() at any one time.
+ */
+template <size_t capacity>
+class ParameterEventQueue
+{
+public:
+    ParameterEventQueue() = default;
+
+    /** Adds an event for the next block, returning false if the queue is full. */
+    bool push(const ParameterEvent& event) noexcept
+    {
+        const auto scope = _fifo.write(1);
+        if (scope.blockSize1 + scope.blockSize2 == 0)
+            return false;
+
+        _ring[size_t(scope.blockSize1 > 0 ? scope.startIndex1 : scope.startIndex2)] = event;
+        return true;
+    }
+
+    /** Returns true if events are waiting, a single atomic load. */
+    bool hasPending() const noexcept
+    {
+        return _fifo.getNumReady() > 0;
+    }
+
+    /**
+     *  Moves all waiting events into dest, stably sorted by sample offset, and returns how
+     *  many there were. Events for the same offset keep the order they were pushed in.
+     */
+    size_t popAll(std::array<ParameterEvent, capacity>& dest) noexcept
+    {
+        size_t numEvents = 0;
+        {
+            const auto scope = _fifo.read(_fifo.getNumReady());
+            scope.forEach([&](int index) { dest[numEvents++] = _ring[size_t(index)]; });
+        }
+
+        // Insertion sort: hosts mostly deliver events in order already, so this stays
+        // close to one pass, and unlike std::stable_sort it never allocates.
+        for (size_t i = 1; i < numEvents; ++i)
+        {
+            const auto event = dest[i];
+            auto j = i;
+            for (; j > 0 && dest[j - 1].sampleOffset > event.sampleOffset; --j)
+                dest[j] = dest[j - 1];
+            dest[j] = event;
+        }
+        return numEvents;
+    }
+
+    /** Drops all waiting events, e.g. for blocks that are not rendered. */
+    void clear() noexcept
+    {
+        _fifo.read(_fifo.getNumReady());
+    }
+
+private:
+    // AbstractFifo keeps one slot free to tell a full ring from an empty one.
+    juce::AbstractFifo _fifo{ int(capacity) + 1 };
+    std::array<ParameterEvent, capacity + 1> _ring{};
+
+    JUCE_DECLARE_NON_COPYABLE(ParameterEventQueue)
+};
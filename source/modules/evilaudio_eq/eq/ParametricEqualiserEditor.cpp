@@ -2,6 +2,7 @@
 
 static int clickRadius = 4;
 static float maxDB = 24.0f;
+static int maxBandEditorsPerRow = 8;
 
 ParametricEqualiserEditor::ParametricEqualiserEditor(ParametricEqualiserProcessor& audioProcessor,
                                                      juce::AudioProcessorValueTreeState& vts)
@@ -16,6 +17,7 @@ ParametricEqualiserEditor::ParametricEqualiserEditor(ParametricEqualiserProcesso
         auto* bandEditor = _bandEditors.add(new BandEditor(i, _audioProcessor, _audioProcessorState));
         addAndMakeVisible(bandEditor);
     }
+    _drawnBandVersions.resize(_audioProcessor.getNumBands(), 0);
     // Create the output frame control.
     _outputGainFrame.setText(TRANS("Output"));
     _outputGainFrame.setTextLabelPosition(juce::Justification::centred);
@@ -30,22 +32,38 @@ ParametricEqualiserEditor::ParametricEqualiserEditor(ParametricEqualiserProcesso
                                                            ParametricEqualiserProcessor::paramOutput, 
                                                            _outputGainSlider));
 
+    // Create the oversampling selector.
+    _oversamplingComboBox.addItemList(ParametricEqualiserProcessor::getOversamplingNames(), 1);
+    _oversamplingComboBox.setTooltip(TRANS("Oversampling"));
+    addAndMakeVisible(_oversamplingComboBox);
+    _oversamplingAttachment.reset(new juce::AudioProcessorValueTreeState::ComboBoxAttachment(_audioProcessorState,
+                                                                                             ParametricEqualiserProcessor::paramOversampling,
+                                                                                             _oversamplingComboBox));
+
+    // Create the phase mode selector.
+    _phaseComboBox.addItemList(ParametricEqualiserProcessor::getPhaseNames(), 1);
+    _phaseComboBox.setTooltip(TRANS("Phase"));
+    addAndMakeVisible(_phaseComboBox);
+    _phaseAttachment.reset(new juce::AudioProcessorValueTreeState::ComboBoxAttachment(_audioProcessorState,
+                                                                                      ParametricEqualiserProcessor::paramPhase,
+                                                                                      _phaseComboBox));
+
     // Initialize the size of the equalizer editor.
     auto size = _audioProcessor.getSavedSize(); 
     setResizable(false, false);
     //setResizable(true, true);
     setSize(size.x, size.y);
     //setSize(size.getHeight(), size.getWidth());
-    setResizeLimits(800, 450, 2990, 1800);
+    setResizeLimits(ParametricEqualiserProcessor::minEditorWidth, ParametricEqualiserProcessor::minEditorHeight,
+                    ParametricEqualiserProcessor::maxEditorWidth, ParametricEqualiserProcessor::maxEditorHeight);
 
+    _audioProcessor.updatePlotData();
     updateFrequencyResponses();
 
 #ifdef JUCE_OPENGL
     openGLContext.attachTo(*getTopLevelComponent());
 #endif
 
-    _audioProcessor.addChangeListener(this);
-
     // Refresh the display at 30 Hz.
     startTimerHz(30);
 }
@@ -53,7 +71,6 @@ ParametricEqualiserEditor::ParametricEqualiserEditor(ParametricEqualiserProcesso
 ParametricEqualiserEditor::~ParametricEqualiserEditor()
 {
     juce::PopupMenu::dismissAllActiveMenus();
-    _audioProcessor.removeChangeListener(this);
 #ifdef JUCE_OPENGL
     openGLContext.detach();
 #endif
@@ -112,14 +129,15 @@ void ParametricEqualiserEditor::paint(juce::Graphics& g) {
     // Draw the frequency response for each band.
     for (size_t i = 0; i < _audioProcessor.getNumBands(); ++i) {
         auto* bandEditor = _bandEditors.getUnchecked(int(i));
-        auto* band = _audioProcessor.getBand(i);
+        const auto& band = _audioProcessor.getBandPlot(i);
+        const auto colour = _audioProcessor.getBandColour(i);
 
-        g.setColour(band->active ? band->colour : band->colour.withAlpha(0.3f));
+        g.setColour(band.active ? colour : colour.withAlpha(0.3f));
         g.strokePath(bandEditor->frequencyResponse, juce::PathStrokeType(1.0));
         
-        g.setColour(_draggingBand == int(i) ? band->colour : band->colour.withAlpha(0.3f));
-        auto x = juce::roundToInt(_plotFrame.getX() + _plotFrame.getWidth() * getPositionForFrequency(float(band->frequency)));
-        auto y = juce::roundToInt(getPositionForGain(float(band->gain), float(_plotFrame.getY()), float(_plotFrame.getBottom())));
+        g.setColour(_draggingBand == int(i) ? colour : colour.withAlpha(0.3f));
+        auto x = juce::roundToInt(_plotFrame.getX() + _plotFrame.getWidth() * getPositionForFrequency(float(band.frequency)));
+        auto y = juce::roundToInt(getPositionForGain(float(band.gain), float(_plotFrame.getY()), float(_plotFrame.getBottom())));
         g.drawVerticalLine(x, float(_plotFrame.getY()), float(y - 5));
         g.drawVerticalLine(x, float(y + 5), float(_plotFrame.getBottom()));
         g.fillEllipse(float(x - 3), float(y - 3), 6.0f, 6.0f);
@@ -133,16 +151,26 @@ void ParametricEqualiserEditor::resized() {
     _audioProcessor.setSavedSize({ getWidth(), getHeight() });
     _plotFrame = getLocalBounds().reduced(3, 3);
 
-    // Resize the band editor controls.
+    // Resize the band editor controls, wrapping them onto several rows when
+    // there are more bands than fit comfortably side by side.
     auto bandSpace = _plotFrame.removeFromBottom(getHeight() / 2);
-    auto bandEditorWidth = juce::roundToInt(bandSpace.getWidth()) / (_bandEditors.size() + 1);
-    for (auto* bandEditor : _bandEditors) {
-        bandEditor->setBounds(bandSpace.removeFromLeft(bandEditorWidth));
+    const auto numRows = juce::jmax(1, (_bandEditors.size() + maxBandEditorsPerRow - 1) / maxBandEditorsPerRow);
+    const auto numColumns = juce::jmax(1, (_bandEditors.size() + numRows - 1) / numRows);
+    auto bandEditorWidth = juce::roundToInt(bandSpace.getWidth()) / (numColumns + 1);
+    auto bandEditorArea = bandSpace.removeFromLeft(bandEditorWidth * numColumns);
+    const auto rowHeight = bandEditorArea.getHeight() / numRows;
+    juce::Rectangle<int> row;
+    for (int i = 0; i < _bandEditors.size(); ++i) {
+        if (i % numColumns == 0)
+            row = bandEditorArea.removeFromTop(rowHeight);
+        _bandEditors.getUnchecked(i)->setBounds(row.removeFromLeft(bandEditorWidth));
     }
 
     // Resize the output level control frame.
     _outputGainFrame.setBounds(bandSpace.removeFromTop(bandSpace.getHeight() / 2));
     _outputGainSlider.setBounds(_outputGainFrame.getBounds().reduced(8));
+    _oversamplingComboBox.setBounds(bandSpace.removeFromTop(30).reduced(8, 3));
+    _phaseComboBox.setBounds(bandSpace.removeFromTop(30).reduced(8, 3));
 
     _plotFrame.reduce(3, 3);
     _brandingFrame = bandSpace.reduced(5);
@@ -150,25 +178,27 @@ void ParametricEqualiserEditor::resized() {
     updateFrequencyResponses();
 }
 
-void ParametricEqualiserEditor::updateFrequencyResponses() {
+void ParametricEqualiserEditor::updateFrequencyResponses(bool allBands) {
     auto pixelsPerDouble = 2.0f * _plotFrame.getHeight() / juce::Decibels::decibelsToGain(maxDB);
 
     for (int i = 0; i < _bandEditors.size(); ++i)
     {
         auto* bandEditor = _bandEditors.getUnchecked(i);
+        const auto version = _audioProcessor.getBandVersion(size_t(i));
 
-        if (auto* band = _audioProcessor.getBand(size_t(i)))
+        if (allBands || version != _drawnBandVersions[size_t(i)])
         {
-            bandEditor->updateControls(band->type);
+            bandEditor->updateControls(_audioProcessor.getBandPlot(size_t(i)).type);
             bandEditor->frequencyResponse.clear();
             _audioProcessor.createFrequencyPlot(bandEditor->frequencyResponse, 
-                                                band->magnitudes, _plotFrame.withX(_plotFrame.getX() + 1), pixelsPerDouble);
+                                                _audioProcessor.getBandResponse(size_t(i)), _plotFrame.withX(_plotFrame.getX() + 1), pixelsPerDouble);
+            _drawnBandVersions[size_t(i)] = version;
         }
         bandEditor->updateSoloState(_audioProcessor.getBandSolo(i));
     }
     _frequencyResponsePath.clear();
     _audioProcessor.createFrequencyPlot(_frequencyResponsePath, 
-                                        _audioProcessor.getMagnitudes(), _plotFrame, pixelsPerDouble);
+                                        _audioProcessor.getResponse(), _plotFrame, pixelsPerDouble);
 };
 
 float ParametricEqualiserEditor::getPositionForFrequency(float freq)
@@ -191,16 +221,18 @@ float ParametricEqualiserEditor::getGainForPosition(float pos, float top, float
     return juce::Decibels::decibelsToGain(juce::jmap(pos, bottom, top, -maxDB, maxDB), -maxDB);
 }
 
-void ParametricEqualiserEditor::changeListenerCallback(juce::ChangeBroadcaster* sender)
-{
-    juce::ignoreUnused(sender);
-    updateFrequencyResponses();
-    repaint();
-}
-
 void ParametricEqualiserEditor::timerCallback()
 {
-    if (_audioProcessor.checkForNewAnalyserData())
+    const auto newAnalyserData = _audioProcessor.checkForNewAnalyserData();
+
+    // However many band updates arrived since the last frame, only the newest curves are
+    // picked up, and only the bands that changed are turned into paths again.
+    if (_audioProcessor.updatePlotData())
+    {
+        updateFrequencyResponses(false);
+        repaint();
+    }
+    else if (newAnalyserData)
         repaint(_plotFrame);
 }
 
@@ -210,26 +242,24 @@ void ParametricEqualiserEditor::mouseDown(const juce::MouseEvent& e) {
 
     for (int i = 0; i < _bandEditors.size(); ++i)
     {
-        if (auto* band = _audioProcessor.getBand(size_t(i)))
+        const auto& band = _audioProcessor.getBandPlot(size_t(i));
+        if (std::abs(_plotFrame.getX() + getPositionForFrequency(float(int(band.frequency)) * _plotFrame.getWidth())
+            - e.position.getX()) < clickRadius)
         {
-            if (std::abs(_plotFrame.getX() + getPositionForFrequency(float(int(band->frequency)) * _plotFrame.getWidth())
-                - e.position.getX()) < clickRadius)
-            {
-                _contextMenu.clear();
-                const auto& names = ParametricEqualiserProcessor::getFilterTypeNames();
-                for (int t = 0; t < names.size(); ++t)
-                    _contextMenu.addItem(t + 1, names[t], true, band->type == t);
-
-                _contextMenu.showMenuAsync(juce::PopupMenu::Options()
-                    .withTargetComponent(this)
-                    .withTargetScreenArea({ e.getScreenX(), e.getScreenY(), 1, 1 })
-                    , [this, i](int selected)
-                    {
-                        if (selected > 0)
-                            _bandEditors.getUnchecked(i)->setType(selected - 1);
-                    });
-                return;
-            }
+            _contextMenu.clear();
+            const auto& names = ParametricEqualiserProcessor::getFilterTypeNames();
+            for (int t = 0; t < names.size(); ++t)
+                _contextMenu.addItem(t + 1, names[t], true, band.type == t);
+
+            _contextMenu.showMenuAsync(juce::PopupMenu::Options()
+                .withTargetComponent(this)
+                .withTargetScreenArea({ e.getScreenX(), e.getScreenY(), 1, 1 })
+                , [this, i](int selected)
+                {
+                    if (selected > 0)
+                        _bandEditors.getUnchecked(i)->setType(selected - 1);
+                });
+            return;
         }
     }
 
@@ -240,30 +270,28 @@ void ParametricEqualiserEditor::mouseMove(const juce::MouseEvent& e) {
     {
         for (int i = 0; i < _bandEditors.size(); ++i)
         {
-            if (auto* band = _audioProcessor.getBand(size_t(i)))
+            const auto& band = _audioProcessor.getBandPlot(size_t(i));
+            auto pos = _plotFrame.getX() + getPositionForFrequency(float(band.frequency)) * _plotFrame.getWidth();
+
+            if (std::abs(pos - e.position.getX()) < clickRadius)
             {
-                auto pos = _plotFrame.getX() + getPositionForFrequency(float(band->frequency)) * _plotFrame.getWidth();
+                if (std::abs(getPositionForGain(float(band.gain), float(_plotFrame.getY()), float(_plotFrame.getBottom()))
+                    - e.position.getY()) < clickRadius)
+                {
+                    _draggingGain = _audioProcessorState.getParameter(_audioProcessor.getGainParamName(size_t(i)));
+                    setMouseCursor(juce::MouseCursor(juce::MouseCursor::UpDownLeftRightResizeCursor));
+                }
+                else
+                {
+                    setMouseCursor(juce::MouseCursor(juce::MouseCursor::LeftRightResizeCursor));
+                }
 
-                if (std::abs(pos - e.position.getX()) < clickRadius)
+                if (i != _draggingBand)
                 {
-                    if (std::abs(getPositionForGain(float(band->gain), float(_plotFrame.getY()), float(_plotFrame.getBottom()))
-                        - e.position.getY()) < clickRadius)
-                    {
-                        _draggingGain = _audioProcessorState.getParameter(_audioProcessor.getGainParamName(size_t(i)));
-                        setMouseCursor(juce::MouseCursor(juce::MouseCursor::UpDownLeftRightResizeCursor));
-                    }
-                    else
-                    {
-                        setMouseCursor(juce::MouseCursor(juce::MouseCursor::LeftRightResizeCursor));
-                    }
-
-                    if (i != _draggingBand)
-                    {
-                        _draggingBand = i;
-                        repaint(_plotFrame);
-                    }
-                    return;
+                    _draggingBand = i;
+                    repaint(_plotFrame);
                 }
+                return;
             }
         }
     };
@@ -284,14 +312,12 @@ void ParametricEqualiserEditor::mouseDoubleClick(const juce::MouseEvent& e) {
     {
         for (size_t i = 0; i < size_t(_bandEditors.size()); ++i)
         {
-            if (auto* band = _audioProcessor.getBand(i))
+            const auto& band = _audioProcessor.getBandPlot(i);
+            if (std::abs(_plotFrame.getX() + getPositionForFrequency(float(band.frequency)) * _plotFrame.getWidth()
+                - e.position.getX()) < clickRadius)
             {
-                if (std::abs(_plotFrame.getX() + getPositionForFrequency(float(band->frequency)) * _plotFrame.getWidth()
-                    - e.position.getX()) < clickRadius)
-                {
-                    if (auto* param = _audioProcessorState.getParameter(_audioProcessor.getActiveParamName(i)))
-                        param->setValueNotifyingHost(param->getValue() < 0.5f ? 1.0f : 0.0f);
-                }
+                if (auto* param = _audioProcessorState.getParameter(_audioProcessor.getActiveParamName(i)))
+                    param->setValueNotifyingHost(param->getValue() < 0.5f ? 1.0f : 0.0f);
             }
         }
     }
@@ -317,6 +343,11 @@ ParametricEqualiserEditor::BandEditor::BandEditor(size_t index,
     addAndMakeVisible(_filterTypeComboBox);
     _boxAttachments.add(new juce::AudioProcessorValueTreeState::ComboBoxAttachment(_audioProcessorState, _audioProcessor.getTypeParamName(index), _filterTypeComboBox));
 
+    _routingComboBox.addItemList(ParametricEqualiserProcessor::getRoutingNames(), 1);
+    addAndMakeVisible(_routingComboBox);
+    _boxAttachments.add(new juce::AudioProcessorValueTreeState::ComboBoxAttachment(_audioProcessorState, _audioProcessor.getRoutingParamName(index), _routingComboBox));
+    _routingComboBox.setTooltip(TRANS("Channels the filter works on"));
+
     addAndMakeVisible(_frequencySlider);
     _attachments.add(new juce::AudioProcessorValueTreeState::SliderAttachment(_audioProcessorState, _audioProcessor.getFrequencyParamName(index), _frequencySlider));
     _frequencySlider.setTooltip(TRANS("Filter's frequency"));
@@ -342,6 +373,13 @@ ParametricEqualiserEditor::BandEditor::BandEditor(size_t index,
     addAndMakeVisible(_activate);
     _activate.setTooltip(TRANS("Activate or deactivate this filter"));
 
+    _dynamic.setClickingTogglesState(true);
+    _dynamic.setColour(juce::TextButton::buttonOnColourId, juce::Colours::orange);
+    _buttonAttachments.add(new juce::AudioProcessorValueTreeState::ButtonAttachment(_audioProcessorState, _audioProcessor.getDynamicParamName(index), _dynamic));
+
+    addAndMakeVisible(_dynamic);
+    _dynamic.setTooltip(TRANS("Let a level detector pull the gain down above the threshold (dynamic)"));
+
 };
 
 void ParametricEqualiserEditor::BandEditor::resized() {
@@ -354,6 +392,7 @@ void ParametricEqualiserEditor::BandEditor::resized() {
     // Position the filter type selection combobox control
     // at the top of the frame.
     _filterTypeComboBox.setBounds(localBounds.removeFromTop(20));
+    _routingComboBox.setBounds(localBounds.removeFromTop(22).withTrimmedTop(2));
 
     // Position the frequency slider.
     auto freqSliderBounds = localBounds.removeFromBottom(localBounds.getHeight() * 2 / 3);
@@ -363,6 +402,7 @@ void ParametricEqualiserEditor::BandEditor::resized() {
     auto buttonBounds = freqSliderBounds.reduced(5).withHeight(20);
     _solo.setBounds(buttonBounds.removeFromLeft(20));
     _activate.setBounds(buttonBounds.removeFromRight(20));
+    _dynamic.setBounds(buttonBounds.withSizeKeepingCentre(20, buttonBounds.getHeight()));
 
     // Position the quality and gain sliders within the remaining localBounds rectangle.
     _quality.setBounds(localBounds.removeFromLeft(localBounds.getWidth() / 2));
@@ -414,6 +454,7 @@ void ParametricEqualiserEditor::BandEditor::updateControls(ParametricEqualiserPr
             _gain.setEnabled(true);
             break;
     }
+    _dynamic.setEnabled(ParametricEqualiserProcessor::hasDynamicGain(type));
 }
 
 void ParametricEqualiserEditor::BandEditor::updateSoloState(bool isSolo)
@@ -33,11 +33,10 @@ Pseudocode plan (detailed step-by-step):
  *
  *  Lifecycle:
  *   - Constructed with references to the processor and its AudioProcessorValueTreeState.
- *   - Registers change listeners and timers as needed in implementation.
+ *   - Polls the processor from a timer for new response curves and analyser data.
  */
 class ParametricEqualiserEditor :
     public juce::AudioProcessorEditor,
-    public juce::ChangeListener,
     public juce::Timer
 {
 public:
@@ -78,25 +77,23 @@ public:
      * rectangles used for plotting.
      */
     void resized() override;
-    /**
-     * Callback for change messages from ChangeBroadcaster(s) this editor listens to.
-     *
-     * @param sender The broadcaster that sent the change message (may be nullptr in some cases).
-     */
-    void changeListenerCallback(juce::ChangeBroadcaster* sender) override;
     /**
      * Timer callback invoked periodically when this object is started as a Timer.
      *
-     * Typical use: update analyser data, refresh display paths, or throttle UI updates.
+     * Polls the processor for new response curves and analyser data once per display frame,
+     * so a burst of parameter changes costs at most one update and repaint per frame.
      */
     void timerCallback() override;
     /**
      * Recompute the frequency response Paths used for global and per-band rendering.
      *
-     * This function should sample the filter responses and construct juce::Path objects
-     * stored in the editor for painting.
+     * Builds juce::Path objects from the response curves last picked up with
+     * ParametricEqualiserProcessor::updatePlotData().
+     *
+     * @param allBands True to rebuild every band path, e.g. after the plot was resized; false
+     *                 to rebuild only the bands whose version changed since they were drawn.
      */
-    void updateFrequencyResponses();
+    void updateFrequencyResponses(bool allBands = true);
 
     /**
      * Mouse event handlers to support direct-manipulation of bands on the response plot.
@@ -231,6 +228,8 @@ private:
         juce::GroupComponent _frame;
         /** Combo box that selects the filter type for this band. */
         juce::ComboBox _filterTypeComboBox;
+        /** Combo box that selects the channels this band filters (stereo, left, right, mid or side). */
+        juce::ComboBox _routingComboBox;
 
         /** Rotary slider controlling the filter frequency. */
         juce::Slider _frequencySlider{
@@ -255,6 +254,10 @@ private:
         juce::TextButton _activate{
             TRANS("A")
         };
+        /** Toggle button that makes the gain of this band dynamic (labelled "D"). */
+        juce::TextButton _dynamic{
+            TRANS("D")
+        };
         /** ComboBox attachments used to connect the UI to the VTS. */
         juce::OwnedArray<juce::AudioProcessorValueTreeState::ComboBoxAttachment> _boxAttachments;
         /** Slider attachments used to connect the UI sliders to the VTS. */
@@ -291,6 +294,15 @@ private:
     /** Attachment that binds the output gain slider to the VTS. */
     std::unique_ptr<SliderAttachment> _outputGainSliderAttachment;
 
+    /** Combo box that selects the oversampling factor. */
+    juce::ComboBox _oversamplingComboBox;
+    /** Attachment that binds the oversampling combo box to the VTS. */
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> _oversamplingAttachment;
+    /** Combo box that switches between the minimum phase cascade and the linear phase modes. */
+    juce::ComboBox _phaseComboBox;
+    /** Attachment that binds the phase combo box to the VTS. */
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> _phaseAttachment;
+
 
     /** Rectangle describing the plotting area for frequency response rendering. */
     juce::Rectangle<int> _plotFrame;
@@ -304,6 +316,8 @@ private:
     juce::Path _frequencyResponsePath;
     /** Cached analyser path used when visualising audio in real-time. */
     juce::Path _analyserPath;
+    /** Band versions the per-band response paths were built from. */
+    std::vector<juce::uint32> _drawnBandVersions;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ParametricEqualiserEditor)
 
@@ -2,22 +2,86 @@
 #include "ParametricEqualiserEditor.h"
 
 juce::String ParametricEqualiserProcessor::paramOutput("output");
+juce::String ParametricEqualiserProcessor::paramOversampling("oversampling");
+juce::String ParametricEqualiserProcessor::paramOversamplingFilter("oversampling-filter");
+juce::String ParametricEqualiserProcessor::paramDesign("design");
+juce::String ParametricEqualiserProcessor::paramPhase("phase");
 juce::String ParametricEqualiserProcessor::paramType("type");
 juce::String ParametricEqualiserProcessor::paramFrequency("frequency");
 juce::String ParametricEqualiserProcessor::paramQuality("quality");
 juce::String ParametricEqualiserProcessor::paramGain("gain");
 juce::String ParametricEqualiserProcessor::paramActive("active");
+juce::String ParametricEqualiserProcessor::paramDynamic("dynamic");
+juce::String ParametricEqualiserProcessor::paramThreshold("threshold");
+juce::String ParametricEqualiserProcessor::paramRatio("ratio");
+juce::String ParametricEqualiserProcessor::paramAttack("attack");
+juce::String ParametricEqualiserProcessor::paramRelease("release");
+juce::String ParametricEqualiserProcessor::paramSidechain("sidechain");
+juce::String ParametricEqualiserProcessor::paramRouting("routing");
+juce::String ParametricEqualiserProcessor::paramMorph("morph");
+juce::String ParametricEqualiserProcessor::paramAutoGain("auto-gain");
 
 namespace IDs
 {
     juce::String editor{ "editor" };
     juce::String sizeX{ "size-x" };
     juce::String sizeY{ "size-y" };
+    juce::String numBands{ "num-bands" };
 }
 
-std::vector<ParametricEqualiserProcessor::Band> createDefaultBands()
+/** Header of the binary state, see getStateInformation(). */
+namespace BinaryState
+{
+    constexpr int magic = 0x51454145;   // "EAEQ" in the byte order of the stream.
+    constexpr int version = 2;         // 2 added the snapshot bank after the parameters.
+    constexpr size_t headerSize = 7 * sizeof(juce::int32);
+    constexpr int maxHeaderCount = 1024;   // Far above any band, field or global count.
+}
+
+/** Sets a parameter to a plain value, notifying the host and the listeners like automation. */
+static void setPlainValue(juce::RangedAudioParameter* parameter, float value)
+{
+    parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+}
+
+static size_t clampNumBands(size_t numBands)
+{
+    return juce::jlimit(size_t(1), ParametricEqualiserProcessor::maxNumBands, numBands);
+}
+
+static bool isValidEditorSize(int width, int height)
+{
+    return width >= ParametricEqualiserProcessor::minEditorWidth && width <= ParametricEqualiserProcessor::maxEditorWidth
+        && height >= ParametricEqualiserProcessor::minEditorHeight && height <= ParametricEqualiserProcessor::maxEditorHeight;
+}
+
+std::vector<ParametricEqualiserProcessor::Band> createDefaultBands(size_t numBands)
 {
     std::vector<ParametricEqualiserProcessor::Band> defaults;
+    if (numBands != ParametricEqualiserProcessor::defaultNumBands)
+    {
+        // Spread the bands evenly over the ten octaves of the display, with shelves at
+        // the ends and cut filters on the outermost bands of larger configurations.
+        const auto hasCutFilters = numBands >= ParametricEqualiserProcessor::defaultNumBands;
+        const auto lowShelf = hasCutFilters ? size_t(1) : size_t(0);
+        const auto highShelf = hasCutFilters ? numBands - 2 : numBands - 1;
+
+        for (size_t i = 0; i < numBands; ++i)
+        {
+            auto type = ParametricEqualiserProcessor::Peak;
+            if (hasCutFilters && i == 0)                   type = ParametricEqualiserProcessor::HighPass;
+            else if (hasCutFilters && i == numBands - 1)   type = ParametricEqualiserProcessor::LowPass;
+            else if (numBands > 1 && i == lowShelf)        type = ParametricEqualiserProcessor::LowShelf;
+            else if (numBands > 1 && i == highShelf)       type = ParametricEqualiserProcessor::HighShelf;
+
+            const auto frequency = 20.0f * std::pow(2.0f, 10.0f * (float(i) + 0.5f) / float(numBands));
+            const auto colour = juce::Colour::fromHSV(0.66f * (1.0f - float(i) / float(numBands)), 0.8f, 0.9f, 1.0f);
+            defaults.push_back(ParametricEqualiserProcessor::Band(TRANS("Band") + " " + juce::String(i + 1), colour, type,
+                                                                  std::round(frequency), 0.707f));
+        }
+        return defaults;
+    }
+
     defaults.push_back(ParametricEqualiserProcessor::Band(TRANS("Lowest"), juce::Colours::blue, ParametricEqualiserProcessor::HighPass, 20.0f, 0.707f));
     defaults.push_back(ParametricEqualiserProcessor::Band(TRANS("Low"), juce::Colours::brown, ParametricEqualiserProcessor::LowShelf, 250.0f, 0.707f));
     defaults.push_back(ParametricEqualiserProcessor::Band(TRANS("Low Mids"), juce::Colours::green, ParametricEqualiserProcessor::Peak, 500.0f, 0.707f));
@@ -27,13 +91,13 @@ std::vector<ParametricEqualiserProcessor::Band> createDefaultBands()
     return defaults;
 }
 
-juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout()
+juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout(size_t numBands)
 {
     std::vector<std::unique_ptr<juce::AudioProcessorParameterGroup>> params;
 
     // setting defaults
     const float maxGain = juce::Decibels::decibelsToGain(24.0f);
-    auto defaults = createDefaultBands();
+    auto defaults = createDefaultBands(numBands);
     {
         auto param = std::make_unique<juce::AudioParameterFloat>(ParametricEqualiserProcessor::paramOutput, TRANS("Output"),
             juce::NormalisableRange<float>(0.0f, 2.0f, 0.01f), 1.0f,
@@ -42,7 +106,55 @@ juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout()
             [](float value, int) {return juce::String(juce::Decibels::gainToDecibels(value), 1) + " dB"; },
             [](juce::String text) {return juce::Decibels::decibelsToGain(text.dropLastCharacters(3).getFloatValue()); });
 
-        auto group = std::make_unique<juce::AudioProcessorParameterGroup>("global", TRANS("Globals"), "|", std::move(param));
+        // Changing the oversampling re-prepares the processor, so it is not offered for automation.
+        auto oversampling = std::make_unique<juce::AudioParameterChoice>(ParametricEqualiserProcessor::paramOversampling,
+            TRANS("Oversampling"),
+            ParametricEqualiserProcessor::getOversamplingNames(),
+            0,
+            juce::AudioParameterChoiceAttributes().withAutomatable(false));
+
+        auto oversamplingFilter = std::make_unique<juce::AudioParameterChoice>(ParametricEqualiserProcessor::paramOversamplingFilter,
+            TRANS("Oversampling Filter"),
+            ParametricEqualiserProcessor::getOversamplingFilterNames(),
+            0,
+            juce::AudioParameterChoiceAttributes().withAutomatable(false));
+
+        auto design = std::make_unique<juce::AudioParameterChoice>(ParametricEqualiserProcessor::paramDesign,
+            TRANS("Filter Design"),
+            ParametricEqualiserProcessor::getDesignNames(),
+            ParametricEqualiserProcessor::Bilinear);
+
+        // Like the oversampling, the phase mode changes the latency and is not automatable.
+        auto phase = std::make_unique<juce::AudioParameterChoice>(ParametricEqualiserProcessor::paramPhase,
+            TRANS("Phase"),
+            ParametricEqualiserProcessor::getPhaseNames(),
+            0,
+            juce::AudioParameterChoiceAttributes().withAutomatable(false));
+
+        // Position between the two snapshots chosen with setMorphSnapshots().
+        auto morph = std::make_unique<juce::AudioParameterFloat>(ParametricEqualiserProcessor::paramMorph, TRANS("Morph"),
+            juce::NormalisableRange<float>(0.0f, 1.0f, 0.001f), 0.0f,
+            TRANS("Snapshot morph"),
+            juce::AudioProcessorParameter::genericParameter,
+            [](float value, int) {return juce::String(juce::roundToInt(value * 100.0f)) + " %"; },
+            [](juce::String text) {return text.dropLastCharacters(2).getFloatValue() * 0.01f; });
+
+        // Keeps the loudness of the filtered signal at that of the input, see getOutputLoudness().
+        auto autoGain = std::make_unique<juce::AudioParameterBool>(ParametricEqualiserProcessor::paramAutoGain,
+            TRANS("Auto Gain"),
+            false,
+            juce::String(),
+            [](float value, int) {return value > 0.5f ? TRANS("on") : TRANS("off"); },
+            [](juce::String text) {return text == TRANS("on"); });
+
+        auto group = std::make_unique<juce::AudioProcessorParameterGroup>("global", TRANS("Globals"), "|",
+            std::move(param),
+            std::move(oversampling),
+            std::move(oversamplingFilter),
+            std::move(design),
+            std::move(phase),
+            std::move(morph),
+            std::move(autoGain));
         params.push_back(std::move(group));
     }
 
@@ -94,12 +206,75 @@ juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout()
             [](float value, int) {return value > 0.5f ? TRANS("active") : TRANS("bypassed"); },
             [](juce::String text) {return text == TRANS("active"); });
 
+        auto dynamicParameter = std::make_unique<juce::AudioParameterBool>(ParametricEqualiserProcessor::getDynamicParamName(i),
+            prefix + TRANS("Dynamic"),
+            false,
+            juce::String(),
+            [](float value, int) {return value > 0.5f ? TRANS("dynamic") : TRANS("static"); },
+            [](juce::String text) {return text == TRANS("dynamic"); });
+
+        auto thresholdParameter = std::make_unique<juce::AudioParameterFloat>(ParametricEqualiserProcessor::getThresholdParamName(i),
+            prefix + TRANS("Threshold"),
+            juce::NormalisableRange<float> {-60.0f, 0.0f, 0.1f},
+            -24.0f,
+            juce::String(),
+            juce::AudioProcessorParameter::genericParameter,
+            [](float value, int) {return juce::String(value, 1) + " dB"; },
+            [](juce::String text) {return text.dropLastCharacters(3).getFloatValue(); });
+
+        auto ratioParameter = std::make_unique<juce::AudioParameterFloat>(ParametricEqualiserProcessor::getRatioParamName(i),
+            prefix + TRANS("Ratio"),
+            juce::NormalisableRange<float> {1.0f, 20.0f, 0.1f, std::log(0.5f) / std::log(3.0f / 19.0f)},
+            2.0f,
+            juce::String(),
+            juce::AudioProcessorParameter::genericParameter,
+            [](float value, int) {return juce::String(value, 1) + ":1"; },
+            [](juce::String text) {return text.upToFirstOccurrenceOf(":", false, false).getFloatValue(); });
+
+        auto attackParameter = std::make_unique<juce::AudioParameterFloat>(ParametricEqualiserProcessor::getAttackParamName(i),
+            prefix + TRANS("Attack"),
+            juce::NormalisableRange<float> {0.1f, 200.0f, 0.1f, std::log(0.5f) / std::log(9.9f / 199.9f)},
+            10.0f,
+            juce::String(),
+            juce::AudioProcessorParameter::genericParameter,
+            [](float value, int) {return juce::String(value, 1) + " ms"; },
+            [](juce::String text) {return text.dropLastCharacters(3).getFloatValue(); });
+
+        auto releaseParameter = std::make_unique<juce::AudioParameterFloat>(ParametricEqualiserProcessor::getReleaseParamName(i),
+            prefix + TRANS("Release"),
+            juce::NormalisableRange<float> {5.0f, 2000.0f, 1.0f, std::log(0.5f) / std::log(95.0f / 1995.0f)},
+            100.0f,
+            juce::String(),
+            juce::AudioProcessorParameter::genericParameter,
+            [](float value, int) {return juce::String(value, 0) + " ms"; },
+            [](juce::String text) {return text.dropLastCharacters(3).getFloatValue(); });
+
+        auto sidechainParameter = std::make_unique<juce::AudioParameterBool>(ParametricEqualiserProcessor::getSidechainParamName(i),
+            prefix + TRANS("Sidechain"),
+            false,
+            juce::String(),
+            [](float value, int) {return value > 0.5f ? TRANS("sidechain") : TRANS("input"); },
+            [](juce::String text) {return text == TRANS("sidechain"); });
+
+        // Linear phase mode runs one kernel on all channels and applies every band in stereo.
+        auto routingParameter = std::make_unique<juce::AudioParameterChoice>(ParametricEqualiserProcessor::getRoutingParamName(i),
+            prefix + TRANS("Channels"),
+            ParametricEqualiserProcessor::getRoutingNames(),
+            BiquadCascadeSettings::Stereo);
+
         auto group = std::make_unique<juce::AudioProcessorParameterGroup>("band" + juce::String(i), defaults[i].name, "|",
             std::move(typeParameter),
             std::move(freqParameter),
             std::move(qltyParameter),
             std::move(gainParameter),
-            std::move(actvParameter));
+            std::move(actvParameter),
+            std::move(dynamicParameter),
+            std::move(thresholdParameter),
+            std::move(ratioParameter),
+            std::move(attackParameter),
+            std::move(releaseParameter),
+            std::move(sidechainParameter),
+            std::move(routingParameter));
 
         params.push_back(std::move(group));
     }
@@ -108,36 +283,101 @@ juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout()
 
 //==============================================================================
 
-ParametricEqualiserProcessor::ParametricEqualiserProcessor() :
+ParametricEqualiserProcessor::ParametricEqualiserProcessor(size_t numBands) :
     AudioProcessor(BusesProperties()
         .withInput("Input", juce::AudioChannelSet::stereo(), true)
         .withOutput("Output", juce::AudioChannelSet::stereo(), true)
+        .withInput("Sidechain", juce::AudioChannelSet::stereo(), false)
     ),
-    _parameters(*this, &_undo, "PARAMS", createParameterLayout())
+    _parameters(*this, &_undo, "PARAMS", createParameterLayout(clampNumBands(numBands)))
 {
     _frequencies.resize(300);
     for (size_t i = 0; i < _frequencies.size(); ++i) {
         _frequencies[i] = 20.0 * std::pow(2.0, i / 30.0);
     }
-    _magnitudes.resize(_frequencies.size());
+    _summedResponse.resize(_frequencies.size(), 0.0);
+    _coefficientCache.prepare(_frequencies.size());
 
-    _bands = createDefaultBands();
+    _bands = createDefaultBands(clampNumBands(numBands));
+    _bandVersions.resize(_bands.size(), 0);
 
     for (size_t i = 0; i < _bands.size(); ++i)
     {
-        _bands[i].magnitudes.resize(_frequencies.size(), 1.0);
-
-        _parameters.addParameterListener(getTypeParamName(i), this);
-        _parameters.addParameterListener(getFrequencyParamName(i), this);
-        _parameters.addParameterListener(getQualityParamName(i), this);
-        _parameters.addParameterListener(getGainParamName(i), this);
-        _parameters.addParameterListener(getActiveParamName(i), this);
+        _bands[i].response.resize(_frequencies.size(), 0.0);
+
+        addParameterTarget(getTypeParamName(i), int(i), ParameterField::Type);
+        addParameterTarget(getFrequencyParamName(i), int(i), ParameterField::Frequency);
+        addParameterTarget(getQualityParamName(i), int(i), ParameterField::Quality);
+        addParameterTarget(getGainParamName(i), int(i), ParameterField::Gain);
+        addParameterTarget(getActiveParamName(i), int(i), ParameterField::Active);
+        addParameterTarget(getDynamicParamName(i), int(i), ParameterField::Dynamics);
+        addParameterTarget(getThresholdParamName(i), int(i), ParameterField::Dynamics);
+        addParameterTarget(getRatioParamName(i), int(i), ParameterField::Dynamics);
+        addParameterTarget(getAttackParamName(i), int(i), ParameterField::Dynamics);
+        addParameterTarget(getReleaseParamName(i), int(i), ParameterField::Dynamics);
+        addParameterTarget(getSidechainParamName(i), int(i), ParameterField::Dynamics);
+        addParameterTarget(getRoutingParamName(i), int(i), ParameterField::Routing);
+
+        // In BandParameter order, which is also the layout of a band record in the binary state.
+        const std::array<juce::String, numBandParameters> parameterIDs{ getTypeParamName(i),
+                                                                         getFrequencyParamName(i),
+                                                                         getQualityParamName(i),
+                                                                         getGainParamName(i),
+                                                                         getActiveParamName(i),
+                                                                         getDynamicParamName(i),
+                                                                         getThresholdParamName(i),
+                                                                         getRatioParamName(i),
+                                                                         getAttackParamName(i),
+                                                                         getReleaseParamName(i),
+                                                                         getSidechainParamName(i),
+                                                                         getRoutingParamName(i) };
+        BandParameters bandParameters;
+        for (size_t p = 0; p < numBandParameters; ++p) {
+            bandParameters[p] = _parameters.getRawParameterValue(parameterIDs[p]);
+            _stateParameters.push_back(_parameters.getParameter(parameterIDs[p]));
+        }
+        _bandParameters.push_back(bandParameters);
     }
-    _parameters.addParameterListener(paramOutput, this);
+    for (const auto* parameterID : { &paramOutput, &paramOversampling, &paramOversamplingFilter, &paramDesign, &paramPhase, &paramMorph, &paramAutoGain })
+        _stateParameters.push_back(_parameters.getParameter(*parameterID));
+    jassert(_stateParameters.size() == _bands.size() * numBandParameters + numGlobalStateParameters);
+
+    addParameterTarget(paramOutput, -1, ParameterField::Output);
+    _outputParameter = _parameters.getRawParameterValue(paramOutput);
+    addParameterTarget(paramOversampling, -1, ParameterField::Latency);
+    addParameterTarget(paramOversamplingFilter, -1, ParameterField::Latency);
+    _oversamplingParameter = _parameters.getRawParameterValue(paramOversampling);
+    _oversamplingFilterParameter = _parameters.getRawParameterValue(paramOversamplingFilter);
+    addParameterTarget(paramDesign, -1, ParameterField::Design);
+    _designParameter = _parameters.getRawParameterValue(paramDesign);
+    addParameterTarget(paramPhase, -1, ParameterField::Latency);
+    _phaseParameter = _parameters.getRawParameterValue(paramPhase);
+    _morphParameter = _parameters.getRawParameterValue(paramMorph);
+    _autoGainParameter = _parameters.getRawParameterValue(paramAutoGain);
+    _pulledValues.resize(_bands.size());
+    _eventValues.resize(_bands.size());
+    _morphValues.resize(_bands.size());
     _parameters.state = juce::ValueTree("PROGRAM_Name");
+
+    PlotData flat;
+    flat.response.resize(_frequencies.size(), 0.0);
+    flat.bandResponses.resize(_bands.size(), std::vector<double>(_frequencies.size(), 0.0));
+    flat.bandVersions.resize(_bands.size(), 0);
+    for (const auto& band : _bands)
+        flat.bands.push_back({ band.type, band.frequency, band.gain, band.active });
+    _plotData.reset(flat);
+
+    _designThread.startThread(juce::Thread::Priority::low);
 }
 
 ParametricEqualiserProcessor::~ParametricEqualiserProcessor() {
+    if (_matchPool != nullptr)
+        _matchPool->removeAllJobs(true, 5000);
+    cancelPendingUpdate();
+    _designThread.stopThread(1000);
+    for (auto& target : _parameterTargets)
+        if (target.parameter != nullptr)
+            target.parameter->removeListener(this);
 };
 
 //==============================================================================
@@ -148,15 +388,18 @@ bool ParametricEqualiserProcessor::checkForNewAnalyserData()
 }
 
 void ParametricEqualiserProcessor::createFrequencyPlot(juce::Path& p, 
-                                                       const std::vector<double>& mags, 
+                                                       const std::vector<double>& response, 
                                                        const juce::Rectangle<int> bounds, 
                                                        float pixelsPerDouble) {
-    p.startNewSubPath(float(bounds.getX()), mags[0] > 0 ? float(bounds.getCentreY() - pixelsPerDouble * std::log(mags[0]) / std::log(2.0)) : bounds.getBottom());
+    // The curves are already in doublings, the zeros of notches end at the bottom.
+    const auto getY = [&](double logMagnitude) {
+        return float(juce::jmin(double(bounds.getBottom()), bounds.getCentreY() - pixelsPerDouble * logMagnitude));
+    };
+    p.startNewSubPath(float(bounds.getX()), getY(response[0]));
     const auto xFactor = static_cast<double> (bounds.getWidth()) / _frequencies.size();
     for (size_t i = 1; i < _frequencies.size(); ++i)
     {
-        p.lineTo(float(bounds.getX() + i * xFactor),
-            float(mags[i] > 0 ? bounds.getCentreY() - pixelsPerDouble * std::log(mags[i]) / std::log(2.0) : bounds.getBottom()));
+        p.lineTo(float(bounds.getX() + i * xFactor), getY(response[i]));
     }
 };
 
@@ -170,12 +413,18 @@ void ParametricEqualiserProcessor::createAnalyserPlot(juce::Path& p,
         _outputAnalyser.createPath(p, bounds.toFloat(), minFreq);
 };  
 
-ParametricEqualiserProcessor::Band* ParametricEqualiserProcessor::getBand(size_t index)
+void ParametricEqualiserProcessor::setAnalyserSettings(bool input, const Analyser<float>::Settings& settings)
 {
-    if (juce::isPositiveAndBelow(index, _bands.size()))
-        return &_bands[index];
-    return nullptr;
-};
+    if (input)
+        _inputAnalyser.setSettings(settings);
+    else
+        _outputAnalyser.setSettings(settings);
+}
+
+Analyser<float>::Settings ParametricEqualiserProcessor::getAnalyserSettings(bool input) const
+{
+    return input ? _inputAnalyser.getSettings() : _outputAnalyser.getSettings();
+}
 
 juce::String ParametricEqualiserProcessor::getBandID(size_t index)
 {
@@ -189,7 +438,7 @@ juce::String ParametricEqualiserProcessor::getBandID(size_t index)
     case 5: return "Highest";
     default: break;
     }
-    return "unknown";
+    return "Band" + juce::String(index + 1);
 }
 
 juce::String ParametricEqualiserProcessor::getBandName(size_t index) const {
@@ -206,7 +455,7 @@ juce::Colour ParametricEqualiserProcessor::getBandColour(size_t index) const {
 
 int ParametricEqualiserProcessor::getBandIndexFromID(juce::String paramID)
 {
-    for (size_t i = 0; i < 6; ++i)
+    for (size_t i = 0; i < _bands.size(); ++i)
         if (paramID.startsWith(getBandID(i) + "-"))
             return int(i);
     return -1;
@@ -215,7 +464,87 @@ int ParametricEqualiserProcessor::getBandIndexFromID(juce::String paramID)
 void ParametricEqualiserProcessor::setBandSolo(int index)
 {
     _soloedBand = index;
-    updateBypassedStates();
+    _plotsDirty = true;
+    _designThread.notify();
+}
+
+void ParametricEqualiserProcessor::storeSnapshot(int slot)
+{
+    if (!juce::isPositiveAndBelow(slot, numSnapshots))
+        return;
+
+    _snapshots[size_t(slot)] = captureSnapshot();
+    _publishedSnapshots.write(_snapshots);
+}
+
+void ParametricEqualiserProcessor::clearSnapshot(int slot)
+{
+    if (!juce::isPositiveAndBelow(slot, numSnapshots))
+        return;
+
+    _snapshots[size_t(slot)].valid = false;
+    _publishedSnapshots.write(_snapshots);
+}
+
+bool ParametricEqualiserProcessor::hasSnapshot(int slot) const
+{
+    return juce::isPositiveAndBelow(slot, numSnapshots) && _snapshots[size_t(slot)].valid;
+}
+
+void ParametricEqualiserProcessor::recallSnapshot(int slot)
+{
+    if (!hasSnapshot(slot))
+        return;
+
+    const auto& snapshot = _snapshots[size_t(slot)];
+    for (size_t i = 0; i < _bandParameters.size(); ++i)
+        for (size_t p = 0; p < numBandParameters; ++p)
+            if (_bandParameters[i][p]->load() != snapshot.bands[i][p])
+                setPlainValue(_stateParameters[i * numBandParameters + p], snapshot.bands[i][p]);
+
+    // The output gain is the first of the global parameters.
+    if (_outputParameter->load() != snapshot.output)
+        setPlainValue(_stateParameters[_bands.size() * numBandParameters], snapshot.output);
+}
+
+void ParametricEqualiserProcessor::setMorphSnapshots(int slotA, int slotB)
+{
+    const auto engaged = juce::isPositiveAndBelow(slotA, numSnapshots) && juce::isPositiveAndBelow(slotB, numSnapshots);
+    _morphSlots = engaged ? slotA + numSnapshots * slotB : -1;
+}
+
+bool ParametricEqualiserProcessor::exportSnapshots(const juce::File& file) const
+{
+    juce::FileOutputStream stream(file);
+    if (!stream.openedOk())
+        return false;
+
+    stream.setPosition(0);
+    stream.truncate();
+
+    const auto numStored = std::count_if(_snapshots.begin(), _snapshots.end(), [](const Snapshot& snapshot) { return snapshot.valid; });
+    SnapshotLibrary::writeHeader(stream, _bands.size(), numBandParameters, size_t(numStored));
+    for (const auto& snapshot : _snapshots)
+        if (snapshot.valid)
+            writeSnapshot(stream, snapshot);
+
+    stream.flush();
+    return stream.getStatus().wasOk();
+}
+
+bool ParametricEqualiserProcessor::importSnapshot(const SnapshotLibrary& library, size_t index, int slot)
+{
+    const auto* record = library.getRecord(index);
+    if (record == nullptr || !juce::isPositiveAndBelow(slot, numSnapshots))
+        return false;
+
+    // Reads straight from the mapped file, only this record is paged in.
+    juce::MemoryInputStream stream(record, library.getRecordSize(), false);
+    auto snapshot = captureSnapshot();
+    readSnapshot(stream, snapshot, library.getNumBands(), library.getNumFields());
+    _snapshots[size_t(slot)] = snapshot;
+    _publishedSnapshots.write(_snapshots);
+    return true;
 }
 
 bool ParametricEqualiserProcessor::getBandSolo(int index) const {
@@ -227,8 +556,30 @@ size_t ParametricEqualiserProcessor::getNumBands() const
     return _bands.size();
 }
 
-const std::vector<double>& ParametricEqualiserProcessor::getMagnitudes() {
-    return _magnitudes;
+bool ParametricEqualiserProcessor::updatePlotData() {
+    return _plotData.update();
+}
+
+const std::vector<double>& ParametricEqualiserProcessor::getResponse() const {
+    return _plotData.getReadBuffer().response;
+}
+
+const std::vector<double>& ParametricEqualiserProcessor::getBandResponse(size_t index) const {
+    const auto& bandResponses = _plotData.getReadBuffer().bandResponses;
+    jassert(index < bandResponses.size());
+    return bandResponses[juce::jmin(index, bandResponses.size() - 1)];
+}
+
+juce::uint32 ParametricEqualiserProcessor::getBandVersion(size_t index) const {
+    const auto& bandVersions = _plotData.getReadBuffer().bandVersions;
+    jassert(index < bandVersions.size());
+    return bandVersions[juce::jmin(index, bandVersions.size() - 1)];
+}
+
+const ParametricEqualiserProcessor::BandPlot& ParametricEqualiserProcessor::getBandPlot(size_t index) const {
+    const auto& bands = _plotData.getReadBuffer().bands;
+    jassert(index < bands.size());
+    return bands[juce::jmin(index, bands.size() - 1)];
 }
 
 juce::String ParametricEqualiserProcessor::getTypeParamName(size_t index)
@@ -256,6 +607,41 @@ juce::String ParametricEqualiserProcessor::getActiveParamName(size_t index)
     return getBandID(index) + "-" + paramActive;
 }
 
+juce::String ParametricEqualiserProcessor::getDynamicParamName(size_t index)
+{
+    return getBandID(index) + "-" + paramDynamic;
+}
+
+juce::String ParametricEqualiserProcessor::getThresholdParamName(size_t index)
+{
+    return getBandID(index) + "-" + paramThreshold;
+}
+
+juce::String ParametricEqualiserProcessor::getRatioParamName(size_t index)
+{
+    return getBandID(index) + "-" + paramRatio;
+}
+
+juce::String ParametricEqualiserProcessor::getAttackParamName(size_t index)
+{
+    return getBandID(index) + "-" + paramAttack;
+}
+
+juce::String ParametricEqualiserProcessor::getReleaseParamName(size_t index)
+{
+    return getBandID(index) + "-" + paramRelease;
+}
+
+juce::String ParametricEqualiserProcessor::getSidechainParamName(size_t index)
+{
+    return getBandID(index) + "-" + paramSidechain;
+}
+
+juce::String ParametricEqualiserProcessor::getRoutingParamName(size_t index)
+{
+    return getBandID(index) + "-" + paramRouting;
+}
+
 juce::StringArray ParametricEqualiserProcessor::getFilterTypeNames()
 {
     return {
@@ -274,143 +660,499 @@ juce::StringArray ParametricEqualiserProcessor::getFilterTypeNames()
     };
 }
 
-void ParametricEqualiserProcessor::parameterChanged(const juce::String& parameter, float newValue) {
-    if (parameter == paramOutput) {
-        _filterChain.get<6>().setGainLinear(newValue);
-        updatePlots();
+juce::StringArray ParametricEqualiserProcessor::getOversamplingNames()
+{
+    return {
+        TRANS("Off"),
+        "2x",
+        "4x",
+        "8x"
+    };
+}
+
+juce::StringArray ParametricEqualiserProcessor::getOversamplingFilterNames()
+{
+    return {
+        TRANS("Minimum Phase"),
+        TRANS("Linear Phase")
+    };
+}
+
+juce::StringArray ParametricEqualiserProcessor::getDesignNames()
+{
+    return {
+        TRANS("Bilinear"),
+        TRANS("Matched")
+    };
+}
+
+juce::StringArray ParametricEqualiserProcessor::getPhaseNames()
+{
+    return {
+        TRANS("Minimum Phase"),
+        TRANS("Linear Phase") + " 4096",
+        TRANS("Linear Phase") + " 16384"
+    };
+}
+
+juce::StringArray ParametricEqualiserProcessor::getRoutingNames()
+{
+    return {
+        TRANS("Stereo"),
+        TRANS("Left"),
+        TRANS("Right"),
+        TRANS("Mid"),
+        TRANS("Side")
+    };
+}
+
+bool ParametricEqualiserProcessor::hasDynamicGain(FilterType type) {
+    return type == LowShelf || type == Peak || type == HighShelf;
+}
+
+bool ParametricEqualiserProcessor::isLatencyParameter(const juce::String& parameterID) {
+    return parameterID == paramOversampling || parameterID == paramOversamplingFilter || parameterID == paramPhase;
+}
+
+int ParametricEqualiserProcessor::getOversamplingFactor() const {
+    return 1 << _oversamplingOrder;
+}
+
+bool ParametricEqualiserProcessor::addParameterEvent(int parameterIndex, float newValue, int sampleOffset) noexcept {
+    return _parameterEvents.push({ parameterIndex, newValue, sampleOffset });
+}
+
+LoudnessMeter::Loudness ParametricEqualiserProcessor::getInputLoudness() const noexcept {
+    return _inputMeter.getLoudness();
+}
+
+LoudnessMeter::Loudness ParametricEqualiserProcessor::getOutputLoudness() const noexcept {
+    return _filteredMeter.getLoudness();
+}
+
+void ParametricEqualiserProcessor::resetLoudness() noexcept {
+    _inputMeter.resetIntegrated();
+    _filteredMeter.resetIntegrated();
+}
+
+void ParametricEqualiserProcessor::startMatchCapture(MatchSpectrum spectrum)
+{
+    stopMatchCapture();
+    _matchSpectra[size_t(spectrum)].clear();
+    _inputAnalyser.startCapture();
+    _matchCapture = int(spectrum);
+}
+
+void ParametricEqualiserProcessor::stopMatchCapture()
+{
+    const auto spectrum = _matchCapture.exchange(-1);
+    if (spectrum < 0)
         return;
+
+    _inputAnalyser.stopCapture();
+    _inputAnalyser.getAverageSpectrum(_frequencies, matchSmoothingOctaves, _matchSpectra[size_t(spectrum)]);
+}
+
+bool ParametricEqualiserProcessor::hasMatchSpectrum(MatchSpectrum spectrum) const
+{
+    return !_matchSpectra[size_t(spectrum)].empty();
+}
+
+bool ParametricEqualiserProcessor::startMatch()
+{
+    if (isMatching() || !hasMatchSpectrum(MatchReference) || !hasMatchSpectrum(MatchTarget))
+        return false;
+
+    const auto sampleRate = _sampleRate.load();
+    auto problem = std::make_shared<MatchFitter::Problem>();
+    problem->frequencies = _frequencies;
+    problem->sampleRate = sampleRate > 0.0 ? sampleRate : 48000.0;
+    problem->matched = _designParameter->load() >= 0.5f;
+    problem->numBands = _bands.size();
+
+    // Fit where both spectra hold something above their noise, below Nyquist.
+    const auto& reference = _matchSpectra[MatchReference];
+    const auto& target = _matchSpectra[MatchTarget];
+    const auto range = matchRangeDecibels / juce::Decibels::gainToDecibels(2.0);
+    const auto referenceFloor = *std::max_element(reference.begin(), reference.end()) - range;
+    const auto targetFloor = *std::max_element(target.begin(), target.end()) - range;
+
+    problem->target.resize(_frequencies.size());
+    problem->weights.resize(_frequencies.size());
+    auto level = 0.0, weights = 0.0;
+    for (size_t i = 0; i < _frequencies.size(); ++i) {
+        const auto included = reference[i] > referenceFloor && target[i] > targetFloor
+                               && _frequencies[i] < 0.45 * problem->sampleRate;
+        problem->weights[i] = included ? 1.0 : 0.0;
+        problem->target[i] = reference[i] - target[i];
+        level += problem->weights[i] * problem->target[i];
+        weights += problem->weights[i];
     }
-    int index = getBandIndexFromID(parameter);
-    if (juce::isPositiveAndBelow(index, _bands.size()))
-    {
-        auto* band = getBand(size_t(index));
-        if (parameter.endsWith(paramType)) {
-            band->type = static_cast<FilterType> (static_cast<int> (newValue));
-        }
-        else if (parameter.endsWith(paramFrequency)) {
-            band->frequency = newValue;
-        }
-        else if (parameter.endsWith(paramQuality)) {
-            band->quality = newValue;
-        }
-        else if (parameter.endsWith(paramGain)) {
-            band->gain = newValue;
-        }
-        else if (parameter.endsWith(paramActive)) {
-            band->active = newValue >= 0.5f;
-        }
-        updateBand(size_t(index));
+    if (weights <= 0.0)
+        return false;
+
+    // The level difference is not a tonal one, take it out.
+    const auto maxLogGain = MatchFitter::maxGainDecibels / juce::Decibels::gainToDecibels(2.0);
+    level /= weights;
+    for (auto& difference : problem->target)
+        difference = juce::jlimit(-maxLogGain, maxLogGain, difference - level);
+
+    if (_matchPool == nullptr)
+        _matchPool = std::make_unique<juce::ThreadPool>(juce::jmin(MatchFitter::numLayouts, juce::SystemStats::getNumCpus()));
+
+    _matchResults.assign(size_t(MatchFitter::numLayouts), MatchFitter::Result());
+    _pendingMatchJobs = MatchFitter::numLayouts;
+    for (int layout = 0; layout < MatchFitter::numLayouts; ++layout) {
+        _matchPool->addJob([this, problem, layout] {
+            _matchResults[size_t(layout)] = MatchFitter::fit(*problem, layout);
+            if (--_pendingMatchJobs == 0) {
+                _matchFinished = true;
+                triggerAsyncUpdate();
+            }
+        });
+    }
+    return true;
+}
+
+bool ParametricEqualiserProcessor::isMatching() const
+{
+    return _pendingMatchJobs.load() > 0 || _matchFinished.load();
+}
+
+double ParametricEqualiserProcessor::getMatchError() const
+{
+    return _matchError;
+}
+
+void ParametricEqualiserProcessor::applyMatch()
+{
+    const auto best = std::min_element(_matchResults.begin(), _matchResults.end(),
+        [](const MatchFitter::Result& a, const MatchFitter::Result& b) { return a.error < b.error; });
+    if (best == _matchResults.end() || best->bands.size() != _bands.size() || !std::isfinite(best->error))
+        return;
+
+    _matchError = best->error;
+    for (size_t i = 0; i < _bands.size(); ++i) {
+        const auto& band = best->bands[i];
+        const auto type = band.shape == MatchFitter::LowShelf ? LowShelf
+                        : band.shape == MatchFitter::HighShelf ? HighShelf : Peak;
+        const auto* parameters = &_stateParameters[i * numBandParameters];
+        setPlainValue(parameters[TypeParameter], float(type));
+        setPlainValue(parameters[FrequencyParameter], float(band.frequency));
+        setPlainValue(parameters[QualityParameter], float(band.quality));
+        setPlainValue(parameters[GainParameter], float(band.gain));
+        setPlainValue(parameters[ActiveParameter], 1.0f);
+        setPlainValue(parameters[DynamicParameter], 0.0f);
+    }
+}
+
+CoefficientCache::Statistics ParametricEqualiserProcessor::getCoefficientCacheStatistics() const {
+    return _coefficientCache.getStatistics();
+}
+
+void ParametricEqualiserProcessor::stopDesignThread() {
+    _designThread.stopThread(1000);
+}
+
+void ParametricEqualiserProcessor::runDesignPass() {
+    // Two threads designing at once would race on the bands and the cascade settings.
+    jassert(!_designThread.isThreadRunning());
+    designPendingBands();
+}
+
+void ParametricEqualiserProcessor::addParameterTarget(const juce::String& parameterID, int band, ParameterField field) {
+    auto* parameter = _parameters.getParameter(parameterID);
+    jassert(parameter != nullptr);
+    jassert((field == ParameterField::Latency) == isLatencyParameter(parameterID));
+
+    const auto index = size_t(parameter->getParameterIndex());
+    if (index >= _parameterTargets.size())
+        _parameterTargets.resize(index + 1);
+
+    _parameterTargets[index] = { parameter, band, field };
+    parameter->addListener(this);
+}
+
+void ParametricEqualiserProcessor::parameterValueChanged(int parameterIndex, float newValue) {
+    // A plain table lookup, so that automation never builds or compares strings.
+    if (juce::isPositiveAndBelow(parameterIndex, _parameterTargets.size())) {
+        const auto& target = _parameterTargets[size_t(parameterIndex)];
+        if (target.parameter != nullptr)
+            parameterChanged(target, target.parameter->convertFrom0to1(newValue));
+    }
+}
+
+void ParametricEqualiserProcessor::parameterGestureChanged(int, bool) {
+}
+
+void ParametricEqualiserProcessor::parameterChanged(const ParameterTarget& target, float newValue) {
+    // Only flag the change here, the listener may be called on the host's automation or
+    // audio thread. The design thread picks the new values up from the parameters.
+    juce::ignoreUnused(newValue);
+    if (target.field == ParameterField::Output)
+        _plotsDirty = true;
+    else if (target.field == ParameterField::Latency) {
+        _prepareDirty = true;
+        triggerAsyncUpdate();
     }
+    else if (target.field == ParameterField::Design)
+        _dirtyBands = ~juce::uint32(0);
+    else if (juce::isPositiveAndBelow(target.band, _bands.size()))
+        _dirtyBands.fetch_or(juce::uint32(1) << target.band);
 };
 
-void ParametricEqualiserProcessor::updateBand(const size_t index) {
-    if (_sampleRate > 0) {
-        juce::dsp::IIR::Coefficients<float>::Ptr newCoefficients;
-        switch (_bands[index].type) {
-            case NoFilter:
-                newCoefficients = new juce::dsp::IIR::Coefficients<float>(1, 0, 1, 0);
-                break;
-            case LowPass:
-                newCoefficients = juce::dsp::IIR::Coefficients<float>::makeLowPass(_sampleRate, _bands[index].frequency, _bands[index].quality);
-                break;
-            case LowPass1st:
-                newCoefficients = juce::dsp::IIR::Coefficients<float>::makeFirstOrderLowPass(_sampleRate, _bands[index].frequency);
-                break;
-            case LowShelf:
-                newCoefficients = juce::dsp::IIR::Coefficients<float>::makeLowShelf(_sampleRate, _bands[index].frequency, _bands[index].quality, _bands[index].gain);
-                break;
-            case BandPass:
-                newCoefficients = juce::dsp::IIR::Coefficients<float>::makeBandPass(_sampleRate, _bands[index].frequency, _bands[index].quality);
-                break;
-            case AllPass:
-                newCoefficients = juce::dsp::IIR::Coefficients<float>::makeAllPass(_sampleRate, _bands[index].frequency, _bands[index].quality);
-                break;
-            case AllPass1st:
-                newCoefficients = juce::dsp::IIR::Coefficients<float>::makeFirstOrderAllPass(_sampleRate, _bands[index].frequency);
-                break;
-            case Notch:
-                newCoefficients = juce::dsp::IIR::Coefficients<float>::makeNotch(_sampleRate, _bands[index].frequency, _bands[index].quality);
-                break;
-            case Peak:
-                newCoefficients = juce::dsp::IIR::Coefficients<float>::makePeakFilter(_sampleRate, _bands[index].frequency, _bands[index].quality, _bands[index].gain);
-                break;
-            case HighShelf:
-                newCoefficients = juce::dsp::IIR::Coefficients<float>::makeHighShelf(_sampleRate, _bands[index].frequency, _bands[index].quality, _bands[index].gain);
-                break;
-            case HighPass1st:
-                newCoefficients = juce::dsp::IIR::Coefficients<float>::makeFirstOrderHighPass(_sampleRate, _bands[index].frequency);
-                break;
-            case HighPass:
-                newCoefficients = juce::dsp::IIR::Coefficients<float>::makeHighPass(_sampleRate, _bands[index].frequency, _bands[index].quality);
-                break;
-            case LastFilterID:
-            default:
-                break;
+void ParametricEqualiserProcessor::pullParameters() noexcept {
+    juce::uint32 dirty = 0;
+    for (size_t i = 0; i < _bandParameters.size(); ++i) {
+        for (size_t p = 0; p < numBandParameters; ++p) {
+            const auto value = _bandParameters[i][p]->load(std::memory_order_relaxed);
+            if (value != _pulledValues[i][p]) {
+                _pulledValues[i][p] = value;
+                dirty |= juce::uint32(1) << i;
+            }
         }
+    }
+    if (dirty != 0) {
+        _dirtyBands.fetch_or(dirty);
+        _detectorsDirty |= dirty;
+    }
 
-        if (newCoefficients)
-        {
-            {
-                // minimise lock scope, get<0>() needs to be a  compile time constant
-                juce::ScopedLock processLock(getCallbackLock());
-                if (index == 0)
-                    *_filterChain.get<0>().state = *newCoefficients;
-                else if (index == 1)
-                    *_filterChain.get<1>().state = *newCoefficients;
-                else if (index == 2)
-                    *_filterChain.get<2>().state = *newCoefficients;
-                else if (index == 3)
-                    *_filterChain.get<3>().state = *newCoefficients;
-                else if (index == 4)
-                    *_filterChain.get<4>().state = *newCoefficients;
-                else if (index == 5)
-                    *_filterChain.get<5>().state = *newCoefficients;
+    const auto output = _outputParameter->load(std::memory_order_relaxed);
+    if (output != _pulledOutput) {
+        _pulledOutput = output;
+        _plotsDirty = true;
+    }
+}
+
+void ParametricEqualiserProcessor::handleAsyncUpdate() {
+    if (_matchFinished.exchange(false))
+        applyMatch();
+
+    // A new oversampling or phase setting needs new filters and a new latency, so go
+    // through the same sequence a host uses when the sample rate changes.
+    if (!_prepareDirty.exchange(false) || getSampleRate() <= 0 || getBlockSize() <= 0)
+        return;
+
+    suspendProcessing(true);
+    releaseResources();
+    prepareToPlay(getSampleRate(), getBlockSize());
+    suspendProcessing(false);
+}
+
+void ParametricEqualiserProcessor::designPendingBands() {
+    const auto dirty = _dirtyBands.exchange(0);
+    const auto plotsDirty = _plotsDirty.exchange(false);
+    if (dirty != 0 || plotsDirty) {
+        for (size_t i = 0; i < _bands.size(); ++i) {
+            const auto bit = juce::uint32(1) << i;
+            if ((dirty & bit) == 0)
+                continue;
+
+            // Take the old curve out of the sum, updatePlots() adds the new one.
+            if ((_summedBands & bit) != 0) {
+                juce::FloatVectorOperations::subtract(_summedResponse.data(), _bands[i].response.data(), int(_summedResponse.size()));
+                _summedBands &= ~bit;
             }
-            newCoefficients->getMagnitudeForFrequencyArray(_frequencies.data(),
-                _bands[index].magnitudes.data(),
-                _frequencies.size(), _sampleRate);
+            updateBand(i);
+            ++_bandVersions[i];
         }
+
         updateBypassedStates();
         updatePlots();
+        updateTailLength();
+        _kernelDirty = true;
+    }
+
+    updateLinearPhaseKernel();
+}
+
+void ParametricEqualiserProcessor::updateTailLength() {
+    const auto sampleRate = _sampleRate.load();
+    if (sampleRate <= 0)
+        return;
+
+    // A linear phase kernel rings for half its length after the delay. The cascade decays
+    // as its slowest pole, the sum over the sections bounds that from above.
+    const auto hostRate = sampleRate / getOversamplingFactor();
+    auto seconds = 0.0;
+    if (_linearPhaseLength > 0) {
+        seconds = double(_linearPhaseLength / 2) / hostRate;
+    }
+    else {
+        for (size_t i = 0; i < _bands.size(); ++i)
+            if (_cascadeSettings.enabled[i])
+                seconds += _cascadeSettings.sections[i].getDecayLength(double(silenceThreshold)) / sampleRate;
     }
+
+    seconds = juce::jmin(seconds, maxTailSeconds);
+    _tailLengthSeconds = seconds;
+    _tailSamples = int(std::ceil(seconds * hostRate));
+}
+
+void ParametricEqualiserProcessor::updateLinearPhaseKernel() {
+    // While the convolver is still fading to the previous kernel this is retried on the
+    // next pass of the design thread, which then catches up with all changes since.
+    if (_linearPhaseLength == 0 || !_kernelDirty || !_convolver.isReadyForKernel())
+        return;
+
+    const auto length = _linearPhaseLength;
+    const auto sampleRate = _sampleRate.load();
+
+    // Real, zero phase spectrum of the bands that the cascade would run.
+    for (size_t k = 0; k <= length / 2; ++k) {
+        auto magnitude = 1.0;
+        for (size_t i = 0; i < _bands.size(); ++i)
+            if (_cascadeSettings.enabled[i])
+                magnitude *= _cascadeSettings.sections[i].getMagnitudeForFrequency(sampleRate * double(k) / double(length), sampleRate);
+
+        _kernelBuffer[2 * k] = float(magnitude);
+        _kernelBuffer[2 * k + 1] = 0.0f;
+        if (k > 0 && k < length / 2) {
+            _kernelBuffer[2 * (length - k)] = float(magnitude);
+            _kernelBuffer[2 * (length - k) + 1] = 0.0f;
+        }
+    }
+    _kernelFFT->performRealOnlyInverseTransform(_kernelBuffer.data());
+
+    // Centre the impulse and window it, which gives a symmetric kernel delayed by length / 2.
+    for (size_t n = 0; n < length; ++n)
+        _kernel[n] = _kernelBuffer[(n + length / 2) % length] * _kernelWindow[n];
+
+    _convolver.setKernel(_kernel.data(), length);
+    _kernelDirty = false;
+}
+
+void ParametricEqualiserProcessor::updateBand(const size_t index) {
+    const auto& parameters = _bandParameters[index];
+    auto& band = _bands[index];
+    band.type = static_cast<FilterType> (static_cast<int> (parameters[TypeParameter]->load()));
+    band.frequency = parameters[FrequencyParameter]->load();
+    band.quality = parameters[QualityParameter]->load();
+    band.gain = parameters[GainParameter]->load();
+    band.active = parameters[ActiveParameter]->load() >= 0.5f;
+    band.dynamic = parameters[DynamicParameter]->load() >= 0.5f;
+    band.routing = static_cast<BiquadCascadeSettings::Routing> (juce::jlimit(0, int(BiquadCascadeSettings::Side),
+                                                                             static_cast<int> (parameters[RoutingParameter]->load())));
+    _cascadeSettings.routing[index] = band.routing;
+
+    const auto sampleRate = _sampleRate.load();
+    if (sampleRate <= 0)
+        return;
+
+    if (band.type == NoFilter) {
+        // Nothing to design, the band is left out of the cascade altogether.
+        _cascadeSettings.sections[index] = {};
+        std::fill(band.response.begin(), band.response.end(), 0.0);
+        return;
+    }
+
+    // Dragging and automation keep coming back to the same positions, so look the design
+    // up first. It is made from the quantised values, which the cache can reproduce.
+    const auto firstOrder = band.type == LowPass1st || band.type == HighPass1st || band.type == AllPass1st;
+    const auto hasGain = band.type == LowShelf || band.type == Peak || band.type == HighShelf;
+    const auto mode = _designParameter->load() >= 0.5f ? Matched : Bilinear;
+    const auto key = _coefficientCache.makeKey(band.type, mode, sampleRate, band.frequency, band.quality, band.gain, !firstOrder, hasGain);
+    if (const auto* cached = _coefficientCache.find(key)) {
+        _cascadeSettings.sections[index] = cached->coefficients;
+        band.response = cached->response;
+        return;
+    }
+
+    // Written straight into the band's slot of the cascade settings, without the heap.
+    _cascadeSettings.sections[index] = designBand(band.type, sampleRate, _coefficientCache.getFrequency(key),
+        _coefficientCache.getQuality(key), _coefficientCache.getGain(key), mode == Matched);
+
+    jassert(_responseEvaluator.getNumPoints() == band.response.size());
+    _responseEvaluator.process(_cascadeSettings.sections[index], band.response.data());
+
+    auto& entry = _coefficientCache.insert(key);
+    entry.coefficients = _cascadeSettings.sections[index];
+    entry.response = band.response;
 };  
     
-void ParametricEqualiserProcessor::updateBypassedStates() {
-    if (juce::isPositiveAndBelow(_soloedBand, _bands.size())) {
-        _filterChain.setBypassed<0>(_soloedBand != 0);
-        _filterChain.setBypassed<1>(_soloedBand != 1);
-        _filterChain.setBypassed<2>(_soloedBand != 2);
-        _filterChain.setBypassed<3>(_soloedBand != 3);
-        _filterChain.setBypassed<4>(_soloedBand != 4);
-        _filterChain.setBypassed<5>(_soloedBand != 5);
+bool ParametricEqualiserProcessor::isUnity(const Band& band) {
+    return isUnity(band.type, band.gain, band.dynamic);
+}
+
+bool ParametricEqualiserProcessor::isUnity(FilterType type, float gain, bool dynamic) noexcept {
+    switch (type) {
+        case NoFilter:
+            return true;
+        case LowShelf:
+        case Peak:
+        case HighShelf:
+            // A dynamic band moves away from its static gain as soon as the detector kicks in.
+            return !dynamic && std::abs(juce::Decibels::gainToDecibels(gain)) < 0.01f;
+        default:
+            return false;
     }
-    else {
-        _filterChain.setBypassed<0>(!_bands[0].active);
-        _filterChain.setBypassed<1>(!_bands[1].active);
-        _filterChain.setBypassed<2>(!_bands[2].active);
-        _filterChain.setBypassed<3>(!_bands[3].active);
-        _filterChain.setBypassed<4>(!_bands[4].active);
-        _filterChain.setBypassed<5>(!_bands[5].active);
-    }
-    updatePlots();
+}
+
+void ParametricEqualiserProcessor::updateBypassedStates() {
+    const auto soloedBand = _soloedBand.load();
+    const auto soloed = juce::isPositiveAndBelow(soloedBand, _bands.size());
+    for (size_t i = 0; i < _bands.size(); ++i)
+        _cascadeSettings.enabled[i] = (soloed ? soloedBand == int(i) : _bands[i].active) && !isUnity(_bands[i]);
+
+    // Publish without blocking the audio thread, processBlock() swaps the new
+    // settings in before it renders the next block.
+    _pendingSettings.write(_cascadeSettings);
 };
 
 void ParametricEqualiserProcessor::updatePlots() {
-    auto gain = _filterChain.get<6>().getGainLinear();
-    std::fill(_magnitudes.begin(), _magnitudes.end(), gain);
+    const auto numPoints = int(_summedResponse.size());
+    const auto soloedBand = _soloedBand.load();
+    const auto soloed = juce::isPositiveAndBelow(soloedBand, _bands.size());
 
-    if (juce::isPositiveAndBelow(_soloedBand, _bands.size())) {
-        juce::FloatVectorOperations::multiply(_magnitudes.data(), _bands[size_t(_soloedBand)].magnitudes.data(), static_cast<int> (_magnitudes.size()));
+    // Bring the sum up to date by adding and taking out single curves. Once no band is
+    // left it starts again from exact zeros, so rounding does not pile up over a session.
+    juce::uint32 shown = 0;
+    for (size_t i = 0; i < _bands.size(); ++i)
+        if (soloed ? soloedBand == int(i) : _bands[i].active)
+            shown |= juce::uint32(1) << i;
+
+    for (size_t i = 0; i < _bands.size(); ++i) {
+        const auto bit = juce::uint32(1) << i;
+        if ((shown & ~_summedBands & bit) != 0)
+            juce::FloatVectorOperations::add(_summedResponse.data(), _bands[i].response.data(), numPoints);
+        else if ((_summedBands & ~shown & bit) != 0)
+            juce::FloatVectorOperations::subtract(_summedResponse.data(), _bands[i].response.data(), numPoints);
     }
-    else
-    {
-        for (size_t i = 0; i < _bands.size(); ++i)
-            if (_bands[i].active)
-                juce::FloatVectorOperations::multiply(_magnitudes.data(), _bands[i].magnitudes.data(), static_cast<int>(_magnitudes.size()));
+    _summedBands = shown;
+    if (shown == 0)
+        std::fill(_summedResponse.begin(), _summedResponse.end(), 0.0);
+
+    auto& plot = _plotData.getWriteBuffer();
+    const auto outputGain = juce::jmax(ResponseEvaluator::minLogMagnitude, std::log2(double(_outputParameter->load())));
+    std::copy(_summedResponse.begin(), _summedResponse.end(), plot.response.begin());
+    juce::FloatVectorOperations::add(plot.response.data(), outputGain, numPoints);
+    for (size_t i = 0; i < _bands.size(); ++i) {
+        const auto& band = _bands[i];
+        if (plot.bandVersions[i] != _bandVersions[i]) {
+            plot.bandResponses[i] = band.response;
+            plot.bandVersions[i] = _bandVersions[i];
+        }
+        plot.bands[i] = { band.type, band.frequency, band.gain, band.active };
     }
-    sendChangeMessage();
+    _plotData.publish();
 };
 
+//==============================================================================
+
+ParametricEqualiserProcessor::DesignThread::DesignThread(ParametricEqualiserProcessor& owner) :
+    juce::Thread("Equaliser-Designer"),
+    _owner(owner)
+{
+}
+
+void ParametricEqualiserProcessor::DesignThread::run() {
+    while (!threadShouldExit())
+    {
+        _owner.designPendingBands();
+        wait(10);
+    }
+}
+
 
 // ----------------------------------------------------------------------------
 // ----------------------------------------------------------------------------
@@ -421,24 +1163,59 @@ const juce::String  ParametricEqualiserProcessor::getName() const {
 }
 
 void  ParametricEqualiserProcessor::prepareToPlay(double newSampleRate, int newSamplesPerBlock) {
-    _sampleRate = newSampleRate;
+    // Design everything here while the design thread is stopped, so that it stays the
+    // only producer of coefficients once it runs again.
+    _designThread.stopThread(1000);
+
+    // Linear phase mode replaces the cascade with one long FIR at the host rate.
+    const auto phase = juce::jlimit(0, getPhaseNames().size() - 1, int(_phaseParameter->load()));
+    _linearPhaseLength = linearPhaseLengths[size_t(phase)];
+
+    // The bands are designed for, and the cascade runs at, the oversampled rate.
+    _oversamplingOrder = _linearPhaseLength > 0 ? 0 : size_t(juce::jlimit(0, getOversamplingNames().size() - 1, int(_oversamplingParameter->load())));
+    const auto linearPhaseOversampling = _oversamplingFilterParameter->load() >= 0.5f;
+    _sampleRate = newSampleRate * getOversamplingFactor();
+    _responseEvaluator.prepare(_frequencies, _sampleRate);
 
     juce::dsp::ProcessSpec spec;
     spec.sampleRate = newSampleRate;
     spec.maximumBlockSize = juce::uint32(newSamplesPerBlock);
-    spec.numChannels = juce::uint32(getTotalNumOutputChannels());
-
-    for (size_t i = 0; i < _bands.size(); ++i) {
-        updateBand(i);
+    spec.numChannels = juce::uint32(juce::jmax(getMainBusNumInputChannels(), getMainBusNumOutputChannels()));
+
+    if (_linearPhaseLength > 0) {
+        const auto partitionSize = juce::jlimit(64, 1024, juce::nextPowerOfTwo(newSamplesPerBlock));
+        _convolver.prepare(size_t(spec.numChannels), size_t(partitionSize), _linearPhaseLength);
+
+        _kernelFFT = std::make_unique<juce::dsp::FFT>(juce::roundToInt(std::log2(double(_linearPhaseLength))));
+        _kernelBuffer.assign(2 * _linearPhaseLength, 0.0f);
+        _kernel.assign(_linearPhaseLength, 0.0f);
+        _kernelWindow.resize(_linearPhaseLength + 1);
+        juce::dsp::WindowingFunction<float>::fillWindowingTables(_kernelWindow.data(), _kernelWindow.size(),
+                                                                  juce::dsp::WindowingFunction<float>::blackman, false);
     }
-    _filterChain.get<6>().setGainLinear(*_parameters.getRawParameterValue(paramOutput));
 
-    updatePlots();
+    _dirtyBands = ~juce::uint32(0);
+    _plotsDirty = true;
+    designPendingBands();
 
-    _filterChain.prepare(spec);
+    _pulledOutput = _outputParameter->load();
+    _detectorsDirty = ~juce::uint32(0);
+    _dynamicBands = 0;
 
-    _inputAnalyser.setupAnalyser(int(_sampleRate), float(_sampleRate));
-    _outputAnalyser.setupAnalyser(int(_sampleRate), float(_sampleRate));
+    if (getProcessingPrecision() == doublePrecision)
+        prepareChain(_doubleChain, spec, linearPhaseOversampling);
+    else
+        prepareChain(_floatChain, spec, linearPhaseOversampling);
+
+    _inputAnalyser.setupAnalyser(int(newSampleRate), float(newSampleRate));
+    _outputAnalyser.setupAnalyser(int(newSampleRate), float(newSampleRate));
+
+    _inputMeter.prepare(newSampleRate, int(spec.numChannels));
+    _inputMeter.setChannelLayout(getChannelLayoutOfBus(true, 0));
+    _filteredMeter.prepare(newSampleRate, int(spec.numChannels));
+    _filteredMeter.setChannelLayout(getChannelLayoutOfBus(false, 0));
+
+    _designThread.startThread(juce::Thread::Priority::low);
 }
 
 void  ParametricEqualiserProcessor::releaseResources() {
@@ -448,38 +1225,543 @@ void  ParametricEqualiserProcessor::releaseResources() {
 
 void ParametricEqualiserProcessor::processBlock(juce::AudioBuffer<float>& buffer, 
                                                 juce::MidiBuffer& midiMessages) {
-    juce::ScopedNoDenormals noDenormals;
     juce::ignoreUnused(midiMessages);
+    process(buffer, _floatChain);
+}
+
+void ParametricEqualiserProcessor::processBlock(juce::AudioBuffer<double>& buffer,
+                                                juce::MidiBuffer& midiMessages) {
+    juce::ignoreUnused(midiMessages);
+    process(buffer, _doubleChain);
+}
+
+bool ParametricEqualiserProcessor::supportsDoublePrecisionProcessing() const {
+    return true;
+}
+
+template <typename SampleType>
+void ParametricEqualiserProcessor::prepareChain(ProcessingChain<SampleType>& chain, const juce::dsp::ProcessSpec& spec, bool linearPhase) {
+    using Oversampling = juce::dsp::Oversampling<SampleType>;
+
+    chain.oversampling.reset();
+    auto cascadeSpec = spec;
+    if (_oversamplingOrder > 0) {
+        // Integer latency, so that the reported latency can be compensated exactly.
+        chain.oversampling = std::make_unique<Oversampling>(size_t(spec.numChannels), _oversamplingOrder,
+            linearPhase ? Oversampling::filterHalfBandFIREquiripple : Oversampling::filterHalfBandPolyphaseIIR,
+            true, true);
+        chain.oversampling->initProcessing(size_t(spec.maximumBlockSize));
+
+        cascadeSpec.sampleRate *= double(getOversamplingFactor());
+        cascadeSpec.maximumBlockSize *= juce::uint32(getOversamplingFactor());
+    }
+    auto latency = chain.oversampling != nullptr ? juce::roundToInt(chain.oversampling->getLatencyInSamples()) : 0;
+    if (_linearPhaseLength > 0)
+        latency += int(_linearPhaseLength / 2) + _convolver.getLatencyInSamples();
+    setLatencySamples(latency);
+
+    // The left/right and mid/side bands pair channels by their types in the output layout.
+    chain.cascade.prepare(cascadeSpec, getChannelLayoutOfBus(false, 0));
+
+    // The detectors run at the host rate, on the main input or the sidechain.
+    auto detectorSpec = spec;
+    if (getBusCount(true) > 1)
+        detectorSpec.numChannels = juce::jmax(spec.numChannels, juce::uint32(getChannelCountOfBus(true, 1)));
+    chain.detector.prepare(detectorSpec);
+
+    chain.outputGain.prepare(spec);
+    chain.outputGain.setGainLinear(SampleType(_pulledOutput));
+    chain.autoGain.prepare(spec);
+    chain.autoGain.setRampDurationSeconds(autoGainRampSeconds);
+    chain.autoGain.setGainDecibels(SampleType(_autoGainDecibels));
+    _wasBypassed = true;
+    _sleeping = false;
+    _silentSamples = 0;
+    _morphing = false;
+}
+
+template <typename SampleType>
+void ParametricEqualiserProcessor::process(juce::AudioBuffer<SampleType>& buffer, ProcessingChain<SampleType>& chain) noexcept {
+    juce::ScopedNoDenormals noDenormals;
 
-    if (getActiveEditor() != nullptr) {
-        _inputAnalyser.addAudioData(buffer, 0, getTotalNumInputChannels());
+    // While a morph is engaged, the snapshots rather than the parameters define the bands.
+    const auto morphChanged = updateMorph();
+
+    // A block with events starts from the values the previous block ended with, the events
+    // then move them within the block. The linear phase kernel only follows at block rate.
+    auto automated = _parameterEvents.hasPending();
+    if (automated && (_linearPhaseLength > 0 || _morphing)) {
+        _parameterEvents.clear();
+        automated = false;
+    }
+    if (automated) {
+        _eventValues = _pulledValues;
+        _eventOutput = _pulledOutput;
     }
 
+    pullParameters();
+    const auto settingsChanged = _pendingSettings.update() || morphChanged;
+    const auto& settings = _morphing ? _morphSettings : _pendingSettings.getReadBuffer();
+    const auto& values = _morphing ? _morphValues : _pulledValues;
+    chain.outputGain.setGainLinear(SampleType(_morphing ? _morphOutput : _pulledOutput));
+
+    // Settings that arrive while asleep are taken over when waking up, which starts the
+    // chain from scratch like after a bypass.
+    if (updateSilence(buffer)) {
+        if (automated)
+            _parameterEvents.clear();
+        auto mainBuffer = getBusBuffer(buffer, false, 0);
+        mainBuffer.clear();
+        _inputMeter.processSilence(size_t(buffer.getNumSamples()));
+        _filteredMeter.processSilence(size_t(buffer.getNumSamples()));
+        return;
+    }
+
+    if (_editorOpen.load(std::memory_order_relaxed) || _matchCapture.load(std::memory_order_relaxed) >= 0) {
+        _inputAnalyser.addAudioData(buffer, 0, getMainBusNumInputChannels());
+    }
+    _inputMeter.process(juce::dsp::AudioBlock<SampleType>(getBusBuffer(buffer, true, 0)));
+
     if (_wasBypassed) {
-        _filterChain.reset();
+        // The settings may have been taken over by the other chain before a precision
+        // switch, so start from the newest ones rather than whatever this chain last saw.
+        chain.cascade.setSettings(settings);
+        chain.cascade.reset();
+        chain.detector.reset();
+        _dynamicBands = 0;
+        chain.outputGain.reset();
+        chain.autoGain.reset();
+        if (chain.oversampling != nullptr)
+            chain.oversampling->reset();
+        if (_linearPhaseLength > 0)
+            _convolver.reset();
         _wasBypassed = false;
     }
-    
-    juce::dsp::AudioBlock<float> ioBuffer(buffer);
-    juce::dsp::ProcessContextReplacing<float> context(ioBuffer);
-    _filterChain.process(context);
+    updateDynamics(buffer, chain, settings, values, settingsChanged);
+
+    // Only the main bus is filtered, a sidechain is only listened to by the detectors.
+    auto mainBuffer = getBusBuffer(buffer, false, 0);
+    juce::dsp::AudioBlock<SampleType> ioBuffer(mainBuffer);
+    if (automated)
+        processAutomated(ioBuffer, chain);
+    else
+        processFilters(ioBuffer, chain);
+    updateAutoGain(chain);
+
+    if (_editorOpen.load(std::memory_order_relaxed)) {
+        _outputAnalyser.addAudioData(buffer, 0, getMainBusNumOutputChannels());
+    }
+}
+
+template <typename SampleType>
+void ParametricEqualiserProcessor::processFilters(juce::dsp::AudioBlock<SampleType> block, ProcessingChain<SampleType>& chain) noexcept {
+    juce::dsp::ProcessContextReplacing<SampleType> context(block);
+    if (_linearPhaseLength > 0) {
+        _convolver.process(block);
+    }
+    else if (chain.oversampling != nullptr) {
+        auto oversampledBuffer = chain.oversampling->processSamplesUp(block);
+        chain.cascade.process(juce::dsp::ProcessContextReplacing<SampleType>(oversampledBuffer));
+        chain.oversampling->processSamplesDown(block);
+    }
+    else {
+        chain.cascade.process(context);
+    }
+    _filteredMeter.process(block);
+    chain.outputGain.process(context);
+    chain.autoGain.process(context);
+}
+
+template <typename SampleType>
+void ParametricEqualiserProcessor::updateAutoGain(ProcessingChain<SampleType>& chain) noexcept {
+    // Matches the short-term loudness, whose 3 s window keeps the gain from pumping. While
+    // either side is below the absolute gate, e.g. in pauses, the last gain is held.
+    if (_autoGainParameter->load(std::memory_order_relaxed) < 0.5f) {
+        _autoGainDecibels = 0.0f;
+    }
+    else {
+        const auto input = _inputMeter.getLoudness().shortTerm;
+        const auto filtered = _filteredMeter.getLoudness().shortTerm;
+        if (input > LoudnessMeter::absoluteGate && filtered > LoudnessMeter::absoluteGate)
+            _autoGainDecibels = juce::jlimit(-maxAutoGainDecibels, maxAutoGainDecibels, input - filtered);
+    }
+    chain.autoGain.setGainDecibels(SampleType(_autoGainDecibels));
+}
+
+template <typename SampleType>
+void ParametricEqualiserProcessor::processAutomated(juce::dsp::AudioBlock<SampleType> block, ProcessingChain<SampleType>& chain) noexcept {
+    const auto numEvents = _parameterEvents.popAll(_blockEvents);
+    const auto numSamples = block.getNumSamples();
+
+    const auto getPosition = [numSamples](const ParameterEvent& event) {
+        return size_t(juce::jlimit(0, int(numSamples), event.sampleOffset));
+    };
+
+    // Dynamic bands ramp to their new gains over the whole block, see updateDynamics(), so
+    // changes within the block finish their ramp at its end as well, where the next one starts.
+    const auto setSettings = [&](size_t position) {
+        if (_dynamicBands != 0)
+            chain.cascade.setSettings(_automatedSettings, (numSamples - position) * size_t(getOversamplingFactor()));
+        else
+            chain.cascade.setSettings(_automatedSettings);
+    };
+
+    // The settings published for this block may already hold the values of the last events,
+    // so start the automated bands from the values the block begins with.
+    juce::uint32 automatedBands = 0;
+    for (size_t e = 0; e < numEvents; ++e) {
+        const auto index = _blockEvents[e].parameterIndex;
+        if (juce::isPositiveAndBelow(index, _parameterTargets.size())) {
+            const auto& target = _parameterTargets[size_t(index)];
+            if (juce::isPositiveAndBelow(target.band, _eventValues.size()) && getBandParameterSlot(target.field) >= 0)
+                automatedBands |= juce::uint32(1) << target.band;
+        }
+    }
+    _automatedSettings = _dynamicBands != 0 ? _dynamicSettings : _pendingSettings.getReadBuffer();
+    designBandsFromValues(_automatedSettings, _eventValues, automatedBands);
+    setSettings(0);
+    chain.outputGain.setGainLinear(SampleType(_eventOutput));
+
+    // Render up to each event position, then apply all events there. The cascade ramps to
+    // the new coefficients from that sample on, like it does for changes at block rate.
+    size_t position = 0, next = 0;
+    while (position < numSamples) {
+        const auto end = next < numEvents ? getPosition(_blockEvents[next]) : numSamples;
+        if (end > position)
+            processFilters(block.getSubBlock(position, end - position), chain);
+        position = end;
+
+        juce::uint32 changed = 0;
+        while (next < numEvents && getPosition(_blockEvents[next]) == position)
+            changed |= applyParameterEvent(_blockEvents[next++], _eventOutput);
+
+        if (changed != 0) {
+            designBandsFromValues(_automatedSettings, _eventValues, changed);
+            setSettings(position);
+        }
+        chain.outputGain.setGainLinear(SampleType(_eventOutput));
+    }
+}
+
+void ParametricEqualiserProcessor::designBandsFromValues(BiquadCascadeSettings& settings, const std::vector<BandValues>& values, juce::uint32 bands) const noexcept {
+    // Designs the given bands on top of settings the rest of the cascade keeps, like the
+    // design thread would from the same values.
+    const auto sampleRate = _sampleRate.load();
+    const auto matched = _designParameter->load(std::memory_order_relaxed) >= 0.5f;
+    const auto soloedBand = _soloedBand.load(std::memory_order_relaxed);
+    const auto soloed = juce::isPositiveAndBelow(soloedBand, values.size());
+    for (size_t i = 0; i < values.size(); ++i) {
+        if ((bands & (juce::uint32(1) << i)) == 0)
+            continue;
+
+        const auto& band = values[i];
+        const auto type = static_cast<FilterType> (static_cast<int> (band[TypeParameter]));
+        const auto active = soloed ? soloedBand == int(i) : band[ActiveParameter] >= 0.5f;
+        settings.sections[i] = designBandFromValues(i, band, sampleRate, matched);
+        settings.enabled[i] = active && !isUnity(type, band[GainParameter], band[DynamicParameter] >= 0.5f);
+        settings.routing[i] = static_cast<BiquadCascadeSettings::Routing> (juce::jlimit(0, int(BiquadCascadeSettings::Side),
+                                                                                        static_cast<int> (band[RoutingParameter])));
+    }
+}
+
+bool ParametricEqualiserProcessor::updateMorph() noexcept {
+    const auto snapshotsChanged = _publishedSnapshots.update();
+    const auto& snapshots = _publishedSnapshots.getReadBuffer();
+    const auto slots = _morphSlots.load(std::memory_order_relaxed);
+    const auto& a = snapshots[size_t(juce::jmax(0, slots) % numSnapshots)];
+    const auto& b = snapshots[size_t(juce::jmax(0, slots) / numSnapshots)];
+
+    // The linear phase kernel is designed away from the audio thread, so it cannot follow.
+    if (slots < 0 || !a.valid || !b.valid || _linearPhaseLength > 0) {
+        const auto changed = _morphing;
+        if (changed)
+            _detectorsDirty = ~juce::uint32(0);
+        _morphing = false;
+        return changed;
+    }
 
-    if (getActiveEditor() != nullptr) {
-        _outputAnalyser.addAudioData(buffer, 0, getTotalNumOutputChannels());
+    const auto morph = juce::jlimit(0.0f, 1.0f, _morphParameter->load(std::memory_order_relaxed));
+    juce::uint32 changed = 0;
+    for (size_t i = 0; i < _morphValues.size(); ++i) {
+        BandValues values;
+        morphBandValues(a.bands[i], b.bands[i], morph, values);
+        if (values != _morphValues[i]) {
+            _morphValues[i] = values;
+            changed |= juce::uint32(1) << i;
+        }
+    }
+    _morphOutput = juce::jmap(morph, a.output, b.output);
+
+    // Engaging, new snapshots, the design mode or the solo state redesign all bands.
+    const auto configuration = (_designParameter->load(std::memory_order_relaxed) >= 0.5f ? 1 : 0)
+                             + 2 * (_soloedBand.load(std::memory_order_relaxed) + 1);
+    if (!_morphing || snapshotsChanged || configuration != _morphConfiguration) {
+        if (!_morphing)
+            _morphSettings = _pendingSettings.getReadBuffer();
+        changed = ~juce::uint32(0);
+        _morphConfiguration = configuration;
+        _morphing = true;
+    }
+    if (changed == 0)
+        return false;
+
+    _detectorsDirty |= changed;
+    designBandsFromValues(_morphSettings, _morphValues, changed);
+    return true;
+}
+
+void ParametricEqualiserProcessor::morphBandValues(const BandValues& a, const BandValues& b, float morph, BandValues& result) noexcept {
+    // Frequency, Q and gain are interpolated on a log scale, which sounds even and keeps
+    // them positive; the detector settings linearly, and choices switch half way.
+    const auto geometric = [morph](float from, float to) {
+        return std::exp(juce::jmap(morph, std::log(juce::jmax(from, 1.0e-6f)), std::log(juce::jmax(to, 1.0e-6f))));
+    };
+    for (size_t p = 0; p < numBandParameters; ++p) {
+        switch (p) {
+            case FrequencyParameter:
+            case QualityParameter:
+            case GainParameter:
+                result[p] = geometric(a[p], b[p]);
+                break;
+            case ThresholdParameter:
+            case RatioParameter:
+            case AttackParameter:
+            case ReleaseParameter:
+                result[p] = juce::jmap(morph, a[p], b[p]);
+                break;
+            default:
+                result[p] = morph < 0.5f ? a[p] : b[p];
+                break;
+        }
+    }
+}
+
+juce::uint32 ParametricEqualiserProcessor::applyParameterEvent(const ParameterEvent& event, float& output) noexcept {
+    // The same table lookup as the parameter listener uses.
+    if (!juce::isPositiveAndBelow(event.parameterIndex, _parameterTargets.size()))
+        return 0;
+
+    const auto& target = _parameterTargets[size_t(event.parameterIndex)];
+    if (target.parameter == nullptr)
+        return 0;
+
+    const auto value = target.parameter->convertFrom0to1(juce::jlimit(0.0f, 1.0f, event.value));
+    if (target.field == ParameterField::Output) {
+        output = value;
+        return 0;
+    }
+    if (!juce::isPositiveAndBelow(target.band, _eventValues.size()))
+        return 0;
+
+    const auto slot = getBandParameterSlot(target.field);
+    if (slot < 0)
+        return 0;
+
+    // Choices are stored as their index, like the parameters hold them.
+    const auto discrete = slot == TypeParameter || slot == RoutingParameter;
+    _eventValues[size_t(target.band)][size_t(slot)] = discrete ? std::round(value) : value;
+    return juce::uint32(1) << target.band;
+}
+
+int ParametricEqualiserProcessor::getBandParameterSlot(ParameterField field) noexcept {
+    switch (field) {
+        case ParameterField::Type:      return TypeParameter;
+        case ParameterField::Frequency: return FrequencyParameter;
+        case ParameterField::Quality:   return QualityParameter;
+        case ParameterField::Gain:      return GainParameter;
+        case ParameterField::Active:    return ActiveParameter;
+        case ParameterField::Routing:   return RoutingParameter;
+        default:
+            // Detector settings follow at block rate, the rest needs the design thread.
+            return -1;
+    }
+}
+
+template <typename SampleType>
+bool ParametricEqualiserProcessor::updateSilence(const juce::AudioBuffer<SampleType>& buffer) noexcept {
+    const auto numSamples = buffer.getNumSamples();
+
+    auto silent = buffer.hasBeenCleared();
+    if (!silent) {
+        silent = true;
+        for (int channel = 0; channel < getMainBusNumInputChannels() && silent; ++channel)
+            silent = buffer.getMagnitude(channel, 0, numSamples) < SampleType(silenceThreshold);
+    }
+
+    if (!silent) {
+        if (_sleeping) {
+            _sleeping = false;
+            _wasBypassed = true;
+        }
+        _silentSamples = 0;
+        return false;
+    }
+
+    _silentSamples = juce::jmin(_silentSamples + numSamples, std::numeric_limits<int>::max() / 2);
+    if (_silentSamples > _tailSamples.load(std::memory_order_relaxed) + getLatencySamples())
+        _sleeping = true;
+    return _sleeping;
+}
+
+template <typename SampleType>
+void ParametricEqualiserProcessor::updateDynamics(juce::AudioBuffer<SampleType>& buffer, ProcessingChain<SampleType>& chain,
+                                                  const BiquadCascadeSettings& settings, const std::vector<BandValues>& values, bool settingsChanged) noexcept {
+    const auto hostRate = getSampleRate();
+
+    // Collect the dynamic bands the cascade runs and bring their detectors up to date. The
+    // linear phase kernel is not redesigned per block, so there all bands stay static.
+    juce::uint32 mainKeyed = 0, sidechainKeyed = 0;
+    for (size_t i = 0; i < values.size() && _linearPhaseLength == 0; ++i) {
+        const auto& band = values[i];
+        const auto type = static_cast<FilterType> (static_cast<int> (band[TypeParameter]));
+        if (!settings.enabled[i] || band[DynamicParameter] < 0.5f || !hasDynamicGain(type))
+            continue;
+
+        const auto bit = juce::uint32(1) << i;
+        if ((_detectorsDirty & bit) != 0) {
+            // Listen to the region the band acts on: around the peak, or below or above the shelf.
+            const auto frequency = juce::jmin(double(band[FrequencyParameter]), 0.45 * hostRate);
+            const auto keyFilter = type == Peak ? BilinearBiquadDesign::makeBandPass(hostRate, frequency, band[QualityParameter])
+                : type == LowShelf ? BilinearBiquadDesign::makeLowPass(hostRate, frequency, juce::MathConstants<double>::sqrt2 * 0.5)
+                : BilinearBiquadDesign::makeHighPass(hostRate, frequency, juce::MathConstants<double>::sqrt2 * 0.5);
+            chain.detector.setDetector(i, keyFilter, band[AttackParameter] * 0.001, band[ReleaseParameter] * 0.001);
+            _detectorsDirty &= ~bit;
+        }
+        if ((_dynamicBands & bit) == 0)
+            chain.detector.clearDetector(i);
+
+        if (band[SidechainParameter] >= 0.5f)
+            sidechainKeyed |= bit;
+        else
+            mainKeyed |= bit;
+    }
+
+    const auto dynamicBands = mainKeyed | sidechainKeyed;
+    if (dynamicBands == 0) {
+        // Fall back to the static settings once the last dynamic band is gone.
+        if (settingsChanged || _dynamicBands != 0)
+            chain.cascade.setSettings(settings);
+        _dynamicBands = 0;
+        return;
+    }
+    _dynamicBands = dynamicBands;
+
+    auto input = getBusBuffer(buffer, true, 0);
+    chain.detector.process(juce::dsp::AudioBlock<SampleType>(input), mainKeyed);
+    if (sidechainKeyed != 0) {
+        // Without a connected sidechain these bands are keyed from the main input.
+        if (getBusCount(true) > 1 && getChannelCountOfBus(true, 1) > 0) {
+            auto sidechain = getBusBuffer(buffer, true, 1);
+            chain.detector.process(juce::dsp::AudioBlock<SampleType>(sidechain), sidechainKeyed);
+        }
+        else {
+            chain.detector.process(juce::dsp::AudioBlock<SampleType>(input), sidechainKeyed);
+        }
+    }
+
+    // Gain computer, once per block and band, on top of the static settings so that a band
+    // returns to its static gain when the key stays below the threshold.
+    _dynamicSettings = settings;
+    const auto sampleRate = _sampleRate.load();
+    const auto matched = _designParameter->load(std::memory_order_relaxed) >= 0.5f;
+    for (size_t i = 0; i < values.size(); ++i) {
+        if ((dynamicBands & (juce::uint32(1) << i)) == 0)
+            continue;
+
+        const auto& band = values[i];
+        const auto level = juce::Decibels::gainToDecibels(float(chain.detector.getLevel(i)));
+        const auto over = level - band[ThresholdParameter];
+        _dynamicReductions[i] = over > 0.0f ? juce::jmin(maxDynamicReductionDecibels, over * (1.0f - 1.0f / band[RatioParameter])) : 0.0f;
+        _dynamicSettings.sections[i] = designBandFromValues(i, band, sampleRate, matched);
+    }
+
+    // Interpolate to the new gains over this block, counted at the rate the cascade runs at.
+    chain.cascade.setSettings(_dynamicSettings, size_t(buffer.getNumSamples()) * size_t(getOversamplingFactor()));
+}
+
+BiquadCoefficients ParametricEqualiserProcessor::designBandFromValues(size_t index, const BandValues& values, double sampleRate, bool matched) const noexcept {
+    // Dynamic bands take the gain reduction of the last block on top of their static gain.
+    auto gain = values[GainParameter];
+    if ((_dynamicBands & (juce::uint32(1) << index)) != 0)
+        gain *= juce::Decibels::decibelsToGain(-_dynamicReductions[index]);
+
+    return designBand(static_cast<FilterType> (static_cast<int> (values[TypeParameter])), sampleRate,
+        values[FrequencyParameter], values[QualityParameter], gain, matched);
+}
+
+BiquadCoefficients ParametricEqualiserProcessor::designBand(FilterType type, double sampleRate, double frequency, double quality, double gain, bool matched) noexcept {
+    // Shared by updateBand() and the audio thread, so dynamic gains and automation events
+    // follow the same designs without the band jumping. Never touches the heap.
+    switch (type) {
+        case LowPass:
+            return matched ? MatchedBiquadDesign::makeLowPass(sampleRate, frequency, quality)
+                           : BilinearBiquadDesign::makeLowPass(sampleRate, frequency, quality);
+        case LowPass1st:
+            return matched ? MatchedBiquadDesign::makeFirstOrderLowPass(sampleRate, frequency)
+                           : BilinearBiquadDesign::makeFirstOrderLowPass(sampleRate, frequency);
+        case LowShelf:
+            return matched ? MatchedBiquadDesign::makeLowShelf(sampleRate, frequency, quality, gain)
+                           : BilinearBiquadDesign::makeLowShelf(sampleRate, frequency, quality, gain);
+        case BandPass:
+            return matched ? MatchedBiquadDesign::makeBandPass(sampleRate, frequency, quality)
+                           : BilinearBiquadDesign::makeBandPass(sampleRate, frequency, quality);
+        case AllPass:
+            return BilinearBiquadDesign::makeAllPass(sampleRate, frequency, quality);
+        case AllPass1st:
+            return BilinearBiquadDesign::makeFirstOrderAllPass(sampleRate, frequency);
+        case Notch:
+            return matched ? MatchedBiquadDesign::makeNotch(sampleRate, frequency, quality)
+                           : BilinearBiquadDesign::makeNotch(sampleRate, frequency, quality);
+        case Peak:
+            return matched ? MatchedBiquadDesign::makePeakFilter(sampleRate, frequency, quality, gain)
+                           : BilinearBiquadDesign::makePeakFilter(sampleRate, frequency, quality, gain);
+        case HighShelf:
+            return matched ? MatchedBiquadDesign::makeHighShelf(sampleRate, frequency, quality, gain)
+                           : BilinearBiquadDesign::makeHighShelf(sampleRate, frequency, quality, gain);
+        case HighPass1st:
+            return matched ? MatchedBiquadDesign::makeFirstOrderHighPass(sampleRate, frequency)
+                           : BilinearBiquadDesign::makeFirstOrderHighPass(sampleRate, frequency);
+        case HighPass:
+            return matched ? MatchedBiquadDesign::makeHighPass(sampleRate, frequency, quality)
+                           : BilinearBiquadDesign::makeHighPass(sampleRate, frequency, quality);
+        case NoFilter:
+        case LastFilterID:
+        default:
+            return {};
     }
 }
 
 bool ParametricEqualiserProcessor::isBusesLayoutSupported(const BusesLayout& busesLayout) const { 
-    
-    // If the processor is running as a plugin it should probably return true????
-    return false;
-///////    return true;
+    // Any layout from mono up to maxNumChannels, the same in and out, surround and ambisonic
+    // ones included. Left/right and mid/side bands work on the left/right pairs of the layout,
+    // such as the front, surround and height pairs; the other channels, centre, LFE, ambisonic
+    // and discrete ones, take every band as a stereo one.
+    const auto mainOutput = busesLayout.getMainOutputChannelSet();
+    if (mainOutput.isDisabled() || mainOutput.size() > maxNumChannels)
+        return false;
+    if (busesLayout.getMainInputChannelSet() != mainOutput)
+        return false;
+
+    // The sidechain is optional, and keys the detectors with up to as many channels.
+    if (busesLayout.inputBuses.size() > 1) {
+        const auto sidechain = busesLayout.getChannelSet(true, 1);
+        if (!sidechain.isDisabled() && sidechain.size() > maxNumChannels)
+            return false;
+    }
+    return true;
 }
 
 juce::AudioProcessorEditor* ParametricEqualiserProcessor::createEditor() { 
+    _editorOpen = true;
     return new ParametricEqualiserEditor(*this, this->_parameters);
 }
 
+void ParametricEqualiserProcessor::editorBeingDeleted(juce::AudioProcessorEditor* editor) noexcept {
+    // Called from the destructor of the editor.
+    _editorOpen = false;
+    juce::AudioProcessor::editorBeingDeleted(editor);
+}
+
 bool ParametricEqualiserProcessor::hasEditor() const {
     return true; 
 }
@@ -497,7 +1779,7 @@ bool  ParametricEqualiserProcessor::isMidiEffect() const {
 }
 
 double  ParametricEqualiserProcessor::getTailLengthSeconds() const { 
-    return 0.0; 
+    return _tailLengthSeconds.load(); 
 }
 
 int  ParametricEqualiserProcessor::getNumPrograms() {
@@ -519,33 +1801,170 @@ void  ParametricEqualiserProcessor::changeProgramName(int, const juce::String&)
 }
 
 void  ParametricEqualiserProcessor::getStateInformation(juce::MemoryBlock& destData) {
-    auto state = _parameters.copyState();
-
-    auto editorProperties = state.getOrCreateChildWithName(IDs::editor, nullptr);
-    editorProperties.setProperty(IDs::sizeX, _editorSize.x, nullptr);
-    editorProperties.setProperty(IDs::sizeY, _editorSize.y, nullptr);
-
-    std::unique_ptr<juce::XmlElement> xml(state.createXml());
-    copyXmlToBinary(*xml, destData);
+    // A header, then one fixed-layout record of plain values per band, then the global
+    // parameters and the snapshot bank. The counts are stored, so newer builds can read
+    // older states and the other way round, skipping or defaulting whatever the other side
+    // did not know.
+    juce::MemoryOutputStream stream(destData, false);
+    stream.writeInt(BinaryState::magic);
+    stream.writeInt(BinaryState::version);
+    stream.writeInt(int(_bands.size()));
+    stream.writeInt(int(numBandParameters));
+    stream.writeInt(int(numGlobalStateParameters));
+    stream.writeInt(_editorSize.x);
+    stream.writeInt(_editorSize.y);
+    for (const auto* parameter : _stateParameters)
+        stream.writeFloat(parameter->convertFrom0to1(parameter->getValue()));
+
+    stream.writeInt(_morphSlots.load());
+    stream.writeInt(numSnapshots);
+    for (const auto& snapshot : _snapshots) {
+        stream.writeInt(snapshot.valid ? 1 : 0);
+        writeSnapshot(stream, snapshot);
+    }
 }
 
 void ParametricEqualiserProcessor::setStateInformation(const void* data, int sizeInBytes) {
+    if (setBinaryState(data, sizeInBytes))
+        return;
+
+    // States saved before the binary format went through the value tree as XML.
     auto xml = getXmlFromBinary(data, sizeInBytes);
     if (xml != nullptr)
     {
         auto tree = juce::ValueTree::fromXml(*xml);
         if (tree.isValid()) {
+            _lastStateNumBands = size_t(juce::jmax(0, xml->getIntAttribute(IDs::numBands, int(defaultNumBands))));
             _parameters.state = tree;
             auto editor = _parameters.state.getChildWithName(IDs::editor);
             if (editor.isValid())
             {
-                _editorSize.setX(editor.getProperty(IDs::sizeX, 900));
-                _editorSize.setY(editor.getProperty(IDs::sizeY, 500));
-                if (auto* thisEditor = getActiveEditor())
-                    thisEditor->setSize(_editorSize.x, _editorSize.y);
+                const int sizeX = editor.getProperty(IDs::sizeX, 900);
+                const int sizeY = editor.getProperty(IDs::sizeY, 500);
+                if (isValidEditorSize(sizeX, sizeY)) {
+                    _editorSize = { sizeX, sizeY };
+                    if (auto* thisEditor = getActiveEditor())
+                        thisEditor->setSize(_editorSize.x, _editorSize.y);
+                }
+            }
+        }
+    }
+}
+
+bool ParametricEqualiserProcessor::setBinaryState(const void* data, int sizeInBytes) {
+    if (data == nullptr || sizeInBytes < int(BinaryState::headerSize))
+        return false;
+
+    juce::MemoryInputStream stream(data, size_t(sizeInBytes), false);
+    if (stream.readInt() != BinaryState::magic || stream.readInt() > BinaryState::version)
+        return false;
+
+    // Counts no version could have written mean a corrupt blob, which is rejected as a whole.
+    const auto numBands = stream.readInt();
+    const auto numFields = stream.readInt();
+    const auto numGlobals = stream.readInt();
+    const auto sizeX = stream.readInt();
+    const auto sizeY = stream.readInt();
+    if (!juce::isPositiveAndNotGreaterThan(numBands, BinaryState::maxHeaderCount)
+        || !juce::isPositiveAndNotGreaterThan(numFields, BinaryState::maxHeaderCount)
+        || numGlobals < 0 || numGlobals > BinaryState::maxHeaderCount)
+        return false;
+    if (stream.getNumBytesRemaining() < (juce::int64(numBands) * numFields + numGlobals) * juce::int64(sizeof(float)))
+        return false;
+
+    // The bands both sides have are restored, the rest are skipped or keep their values.
+    // Callers find out through getLastStateNumBands().
+    _lastStateNumBands = size_t(numBands);
+
+    // Plain values go straight to the parameters, which notify the host and the design
+    // thread as automation would.
+    for (size_t band = 0; band < size_t(numBands); ++band) {
+        for (size_t field = 0; field < size_t(numFields); ++field) {
+            const auto value = stream.readFloat();
+            if (band < _bands.size() && field < numBandParameters)
+                setPlainValue(_stateParameters[band * numBandParameters + field], value);
+        }
+    }
+    const auto firstGlobal = _bands.size() * numBandParameters;
+    for (size_t global = 0; global < size_t(numGlobals); ++global) {
+        const auto value = stream.readFloat();
+        if (global < numGlobalStateParameters)
+            setPlainValue(_stateParameters[firstGlobal + global], value);
+    }
+
+    // Earlier versions end here and leave the snapshots alone.
+    if (stream.getNumBytesRemaining() >= juce::int64(2 * sizeof(juce::int32))) {
+        const auto morphSlots = stream.readInt();
+        const auto numStored = size_t(juce::jmax(0, stream.readInt()));
+        const auto recordSize = sizeof(juce::int32) + (size_t(numBands) * size_t(numFields) + 1) * sizeof(float);
+        if (juce::uint64(stream.getNumBytesRemaining()) >= juce::uint64(numStored) * recordSize) {
+            const auto current = captureSnapshot();
+            for (size_t slot = 0; slot < numStored; ++slot) {
+                auto snapshot = current;
+                snapshot.valid = stream.readInt() != 0;
+                readSnapshot(stream, snapshot, size_t(numBands), size_t(numFields));
+                if (slot < _snapshots.size())
+                    _snapshots[slot] = snapshot;
             }
+            _publishedSnapshots.write(_snapshots);
+            _morphSlots = juce::isPositiveAndBelow(morphSlots, numSnapshots * numSnapshots) ? morphSlots : -1;
         }
     }
+
+    // A size the editor cannot take keeps the current one.
+    if (isValidEditorSize(sizeX, sizeY)) {
+        _editorSize = { sizeX, sizeY };
+        if (auto* thisEditor = getActiveEditor())
+            thisEditor->setSize(_editorSize.x, _editorSize.y);
+    }
+    return true;
+}
+
+ParametricEqualiserProcessor::Snapshot ParametricEqualiserProcessor::captureSnapshot() const {
+    Snapshot snapshot;
+    for (size_t i = 0; i < _bandParameters.size(); ++i)
+        for (size_t p = 0; p < numBandParameters; ++p)
+            snapshot.bands[i][p] = _bandParameters[i][p]->load();
+    snapshot.output = _outputParameter->load();
+    snapshot.valid = true;
+    return snapshot;
+}
+
+void ParametricEqualiserProcessor::writeSnapshot(juce::OutputStream& stream, const Snapshot& snapshot) const {
+    // The record of SnapshotLibrary: the band values in BandParameter order, then the output gain.
+    for (size_t i = 0; i < _bands.size(); ++i)
+        for (size_t p = 0; p < numBandParameters; ++p)
+            stream.writeFloat(snapshot.bands[i][p]);
+    stream.writeFloat(snapshot.output);
+}
+
+void ParametricEqualiserProcessor::readSnapshot(juce::InputStream& stream, Snapshot& snapshot, size_t numBands, size_t numFields) {
+    // Bands and fields the record does not have keep what snapshot held before.
+    for (size_t band = 0; band < numBands; ++band) {
+        for (size_t field = 0; field < numFields; ++field) {
+            const auto value = stream.readFloat();
+            if (band < maxNumBands && field < numBandParameters)
+                snapshot.bands[band][field] = value;
+        }
+    }
+    snapshot.output = stream.readFloat();
+}
+
+size_t ParametricEqualiserProcessor::getNumBandsFromState(const void* data, int sizeInBytes) {
+    if (data != nullptr && sizeInBytes >= int(BinaryState::headerSize)) {
+        juce::MemoryInputStream stream(data, size_t(sizeInBytes), false);
+        if (stream.readInt() == BinaryState::magic && stream.readInt() <= BinaryState::version) {
+            const auto numBands = stream.readInt();
+            return juce::isPositiveAndNotGreaterThan(numBands, BinaryState::maxHeaderCount) ? clampNumBands(size_t(numBands)) : defaultNumBands;
+        }
+    }
+    if (auto xml = getXmlFromBinary(data, sizeInBytes))
+        return clampNumBands(size_t(xml->getIntAttribute(IDs::numBands, int(defaultNumBands))));
+    return defaultNumBands;
+}
+
+size_t ParametricEqualiserProcessor::getLastStateNumBands() const {
+    return _lastStateNumBands;
 }
 
 juce::Point<int> ParametricEqualiserProcessor::getSavedSize() const {
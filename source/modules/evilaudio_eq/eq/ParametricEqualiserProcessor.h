@@ -1,12 +1,23 @@
 #pragma once
 
 #include <juce_audio_processors/juce_audio_processors.h>
+#include <evilaudio_core/evilaudio_core.h>
 #include "Analyser.h"
+#include "BilinearBiquadDesign.h"
+#include "BiquadCascade.h"
+#include "CoefficientCache.h"
+#include "DynamicsDetector.h"
+#include "LockFreeTripleBuffer.h"
+#include "MatchedBiquadDesign.h"
+#include "MatchFitter.h"
+#include "ParameterEventQueue.h"
+#include "ResponseEvaluator.h"
+#include "SnapshotLibrary.h"
 
 class ParametricEqualiserProcessor : 
     public juce::AudioProcessor,
-    public juce::AudioProcessorValueTreeState::Listener,
-    public juce::ChangeBroadcaster
+    public juce::AudioProcessorParameter::Listener,
+    private juce::AsyncUpdater
 {
 public:
     enum FilterType
@@ -26,12 +37,32 @@ public:
         LastFilterID
     };
 
+    /** How band coefficients are derived from their analog prototypes. */
+    enum DesignMode
+    {
+        Bilinear = 0,   ///< RBJ designs through the bilinear transform, as juce::dsp::IIR::Coefficients.
+        Matched         ///< Magnitude matched designs without cramping near Nyquist, see MatchedBiquadDesign.
+    };
+
     static juce::String paramOutput;
+    static juce::String paramOversampling;
+    static juce::String paramOversamplingFilter;
+    static juce::String paramDesign;
+    static juce::String paramPhase;
     static juce::String paramType;
     static juce::String paramFrequency;
     static juce::String paramQuality;
     static juce::String paramGain;
     static juce::String paramActive;
+    static juce::String paramDynamic;
+    static juce::String paramThreshold;
+    static juce::String paramRatio;
+    static juce::String paramAttack;
+    static juce::String paramRelease;
+    static juce::String paramSidechain;
+    static juce::String paramRouting;
+    static juce::String paramMorph;
+    static juce::String paramAutoGain;
 
     static juce::String getBandID(size_t index);
     static juce::String getTypeParamName(size_t index);
@@ -39,9 +70,27 @@ public:
     static juce::String getQualityParamName(size_t index);
     static juce::String getGainParamName(size_t index);
     static juce::String getActiveParamName(size_t index);
+    static juce::String getDynamicParamName(size_t index);
+    static juce::String getThresholdParamName(size_t index);
+    static juce::String getRatioParamName(size_t index);
+    static juce::String getAttackParamName(size_t index);
+    static juce::String getReleaseParamName(size_t index);
+    static juce::String getSidechainParamName(size_t index);
+    static juce::String getRoutingParamName(size_t index);
 
     static juce::StringArray getFilterTypeNames();
+    static juce::StringArray getOversamplingNames();
+    static juce::StringArray getOversamplingFilterNames();
+    static juce::StringArray getDesignNames();
+    static juce::StringArray getPhaseNames();
+    /** Names of the channel routings, in the order of BiquadCascadeSettings::Routing. */
+    static juce::StringArray getRoutingNames();
 
+    /**
+     *  A band as the design thread works on it. Apart from the name and the colour, which never
+     *  change, only the design thread reads or writes it after construction; the editor gets
+     *  what it draws from getBandPlot().
+     */
     struct Band {
         Band(const juce::String& nameToUse, juce::Colour colourToUse, FilterType typeToUse,
             float frequencyToUse, float qualityToUse, float gainToUse = 1.0f, bool shouldBeActive = true)
@@ -62,34 +111,194 @@ public:
         float        quality = 1.0f;
         float        gain = 1.0f;
         bool         active = true;
-        std::vector<double> magnitudes;
+        bool         dynamic = false;   ///< The gain follows a level detector, see hasDynamicGain().
+        BiquadCascadeSettings::Routing routing = BiquadCascadeSettings::Stereo;
+        std::vector<double> response;       ///< log2 of the band's magnitude at each plot frequency.
+    };
+
+    /** The settings a band's published response was designed from. */
+    struct BandPlot
+    {
+        FilterType type = NoFilter;
+        float      frequency = 1000.0f;
+        float      gain = 1.0f;
+        bool       active = false;
     };
 
 public:
-    ParametricEqualiserProcessor();
+    static constexpr size_t defaultNumBands = 6;
+    static constexpr size_t maxNumBands = BiquadCascadeSettings::maxNumSections;
+    /** Widest main and sidechain bus; the filters run the channels in groups of SIMD lanes. */
+    static constexpr int maxNumChannels = 16;
+    /** Resize limits of the editor; saved sizes outside them are not restored. */
+    static constexpr int minEditorWidth = 800;
+    static constexpr int minEditorHeight = 450;
+    static constexpr int maxEditorWidth = 2990;
+    static constexpr int maxEditorHeight = 1800;
+
+    /** Creates an equaliser with between 1 and maxNumBands bands. */
+    explicit ParametricEqualiserProcessor(size_t numBands = defaultNumBands);
     ~ParametricEqualiserProcessor() override;
 
     bool checkForNewAnalyserData();
-    void createFrequencyPlot(juce::Path& p, const std::vector<double>& mags, const juce::Rectangle<int> bounds, float pixelsPerDouble);
+    /** Draws a response curve, which is in log2 of the magnitude, with pixelsPerDouble pixels per doubling. */
+    void createFrequencyPlot(juce::Path& p, const std::vector<double>& response, const juce::Rectangle<int> bounds, float pixelsPerDouble);
     void createAnalyserPlot(juce::Path& p, const juce::Rectangle<int> bounds, float minFreq, bool input);
+    /** Sets the FFT size, overlap, window and averaging of the input or the output analyser. Not for the audio thread. */
+    void setAnalyserSettings(bool input, const Analyser<float>::Settings& settings);
+    Analyser<float>::Settings getAnalyserSettings(bool input) const;
 
-    Band* getBand(size_t index);
     bool getBandSolo(int index) const;
     juce::String getBandName(size_t index) const;
     juce::Colour getBandColour(size_t index) const;
     int getBandIndexFromID(juce::String paramID);
     size_t getNumBands() const;
-    const std::vector<double>& getMagnitudes();
+
+    /**
+     *  Picks up the newest response curves published by the design thread.
+     *
+     *  Nothing is pushed to the message thread; editors poll this once per display frame,
+     *  so any number of band changes in between costs a single update. Call it on the
+     *  message thread before reading getResponse(), getBandResponse(), getBandVersion() or
+     *  getBandPlot().
+     *
+     *  @return true if new curves arrived since the last call.
+     */
+    bool updatePlotData();
+    /** Returns the response of the whole equaliser including the output gain, as log2 of the magnitude. */
+    const std::vector<double>& getResponse() const;
+    /** Returns the response of a single band, as log2 of the magnitude. */
+    const std::vector<double>& getBandResponse(size_t index) const;
+    /** Returns a counter that changes whenever the response of a band does, to redraw only the bands that changed. */
+    juce::uint32 getBandVersion(size_t index) const;
+    /** Returns the type, frequency, gain and active state the band's response was designed from. */
+    const BandPlot& getBandPlot(size_t index) const;
 
     void setBandSolo(int index);
 
+    static constexpr int numSnapshots = 8;
+
+    /** Stores the current parameter values in a snapshot slot. Call this on the message thread. */
+    void storeSnapshot(int slot);
+    /** Empties a snapshot slot. */
+    void clearSnapshot(int slot);
+    bool hasSnapshot(int slot) const;
+    /**
+     *  Writes a snapshot back to the parameters. Only the parameters that differ from the
+     *  snapshot are set, so the host and the listeners only hear about what changes.
+     */
+    void recallSnapshot(int slot);
+    /**
+     *  Renders a morph between two snapshots instead of the parameters.
+     *
+     *  The morph parameter moves from slotA at 0 to slotB at 1. The audio thread designs the
+     *  bands from the interpolated values every block, without allocating, so A/B switching
+     *  is a jump of the morph parameter and the cascade ramps over to the other snapshot.
+     *  Automation events are ignored while a morph is engaged, as is the linear phase mode.
+     *
+     *  @param slotA, slotB  Snapshot slots, or -1 to return to the parameters.
+     */
+    void setMorphSnapshots(int slotA, int slotB);
+    /** Writes the stored snapshots to a library file, see SnapshotLibrary. */
+    bool exportSnapshots(const juce::File& file) const;
+    /** Copies a snapshot of a memory mapped library into a slot. */
+    bool importSnapshot(const SnapshotLibrary& library, size_t index, int slot);
+
+    /**
+     *  Returns true for the filter types whose gain can be driven by the level detector.
+     *
+     *  A dynamic band pulls its gain down by the amount the band limited key signal exceeds
+     *  the threshold, scaled by the ratio, keyed from the main input or the sidechain bus.
+     */
+    static bool hasDynamicGain(FilterType type);
+
+    /**
+     *  Returns true for the oversampling, oversampling filter and phase parameters. They
+     *  change the latency, so a change re-prepares the processor on the message thread.
+     */
+    static bool isLatencyParameter(const juce::String& parameterID);
+
+    /** Returns the oversampling factor the processor was last prepared with, 1 when off. */
+    int getOversamplingFactor() const;
+
+    /**
+     *  Schedules a parameter change at a sample offset into the next block.
+     *
+     *  The block is split at the offsets of its events, so a change starts at its sample
+     *  instead of at the start of the block, with the usual coefficient ramp. The parameter
+     *  itself should hold the value of its last event once the block is processed, as hosts
+     *  leave it after applying an automation queue: the events only place the change within
+     *  the block. Band filter settings and the output gain are sample accurate; detector
+     *  settings, the design mode and the latency settings follow at block rate, and in
+     *  linear phase mode the events are ignored.
+     *
+     *  Wait-free, and may be called from one thread at a time, before processBlock().
+     *
+     *  @param parameterIndex   as returned by juce::AudioProcessorParameter::getParameterIndex()
+     *  @param newValue         the normalised value, as passed to juce::AudioProcessorParameter::setValue()
+     *  @param sampleOffset     the position in the next block, offsets past its end apply at the end
+     *  @return false if the queue is full, the change then only applies through the parameter.
+     */
+    bool addParameterEvent(int parameterIndex, float newValue, int sampleOffset) noexcept;
+
+    /** The two long term average spectra the match EQ compares, both captured from the main input. */
+    enum MatchSpectrum
+    {
+        MatchReference = 0,     ///< The sound to match.
+        MatchTarget             ///< The material the equaliser is applied to.
+    };
+
+    /** Starts averaging the input spectrum into one of the match spectra, dropping what it held. */
+    void startMatchCapture(MatchSpectrum spectrum);
+    /** Stops the capture, keeping the average spectrum if anything was played. */
+    void stopMatchCapture();
+    bool hasMatchSpectrum(MatchSpectrum spectrum) const;
+    /**
+     *  Fits the bands to the difference between the reference and the target spectrum.
+     *
+     *  The fit runs on a thread pool, one job per start layout of MatchFitter, and the best
+     *  fit is written to the parameters on the message thread once all jobs are done: every
+     *  band becomes an active, static peak or shelf. The overall level difference is left
+     *  out, that is for the output gain or auto gain. Call this on the message thread.
+     *
+     *  @return false if a spectrum is missing or a fit is still running.
+     */
+    bool startMatch();
+    bool isMatching() const;
+    /** Returns how far the last fit is from the difference curve, as a weighted RMS in dB. */
+    double getMatchError() const;
+
+    /** Returns how often band designs were found in, or missed, the coefficient cache. */
+    CoefficientCache::Statistics getCoefficientCacheStatistics() const;
+
+    /**
+     *  Test hooks: stopDesignThread() stops the design thread until the next prepareToPlay(),
+     *  after which runDesignPass() designs the changed bands and plots on the calling thread,
+     *  as one pass of the design thread would, so that a test can watch what it does.
+     */
+    void stopDesignThread();
+    void runDesignPass();
+
+    /** Returns the loudness of the main input after EBU R 128. Can be called from any thread. */
+    LoudnessMeter::Loudness getInputLoudness() const noexcept;
+    /**
+     *  Returns the loudness of the filtered signal, before the output and auto gain. Auto
+     *  gain brings its short-term loudness to that of the input. Can be called from any thread.
+     */
+    LoudnessMeter::Loudness getOutputLoudness() const noexcept;
+    /** Starts the integrated loudness of both meters again. Can be called from any thread. */
+    void resetLoudness() noexcept;
+
     // Implement all pure virtual methods from juce::AudioProcessor
     const juce::String getName() const override;
     void prepareToPlay(double, int) override;
     void releaseResources() override;
     void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock(juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override;
     bool isBusesLayoutSupported(const BusesLayout&) const override;
     juce::AudioProcessorEditor* createEditor() override;
+    void editorBeingDeleted(juce::AudioProcessorEditor*) noexcept override;
     bool hasEditor() const override;
     bool acceptsMidi() const override;
     bool producesMidi() const override;
@@ -102,38 +311,299 @@ public:
     const juce::String getProgramName(int) override;
     void changeProgramName(int, const juce::String&) override;
     
+    /** Writes a compact binary state: fixed-layout band records of plain values, the global parameters and the editor size. */
     void getStateInformation(juce::MemoryBlock&) override;
+    /** Restores a binary state by writing the parameters directly, or an XML state written by earlier versions. */
     void setStateInformation(const void*, int) override;
+    /** Returns the band count stored in a state blob, to construct a matching instance before restoring it. */
+    static size_t getNumBandsFromState(const void* data, int sizeInBytes);
+    /**
+     *  Returns the band count of the last state restored, or 0 before the first one.
+     *
+     *  A state with more bands than getNumBands() only restores its first bands, and one with
+     *  fewer leaves the remaining bands alone, so a caller that sees a different count here
+     *  should construct a new instance with getNumBandsFromState() and restore it again.
+     */
+    size_t getLastStateNumBands() const;
     juce::Point<int> getSavedSize() const;
     void setSavedSize(const juce::Point<int>& size);
 
-    // AudioProcessorValueTreeState::Listener method override.
-    void parameterChanged(const juce::String& parameter, float newValue) override;
+    // AudioProcessorParameter::Listener method overrides.
+    void parameterValueChanged(int parameterIndex, float newValue) override;
+    void parameterGestureChanged(int parameterIndex, bool gestureIsStarting) override;
 
 private:
+    enum class ParameterField
+    {
+        None = 0,
+        Output,
+        Type,
+        Frequency,
+        Quality,
+        Gain,
+        Active,
+        Latency,    ///< Settings that change the latency and need the processor to be prepared again.
+        Design,
+        Dynamics,   ///< Detector settings of a dynamic band.
+        Routing
+    };
+
+    /** What a parameter controls, looked up by its parameter index. */
+    struct ParameterTarget
+    {
+        juce::RangedAudioParameter* parameter = nullptr;
+        int band = -1;
+        ParameterField field = ParameterField::None;
+    };
+
+    /** Designs coefficients and response curves away from the audio and automation threads. */
+    class DesignThread : public juce::Thread
+    {
+    public:
+        explicit DesignThread(ParametricEqualiserProcessor& owner);
+        void run() override;
+
+    private:
+        ParametricEqualiserProcessor& _owner;
+    };
+
+    /**
+     *  Response curves handed from the design thread to the editor. Each band curve carries
+     *  the version it was designed in, so publishing only copies the curves that changed
+     *  since this slot was last written.
+     */
+    struct PlotData
+    {
+        std::vector<double> response;
+        std::vector<std::vector<double>> bandResponses;
+        std::vector<juce::uint32> bandVersions;
+        std::vector<BandPlot> bands;
+    };
+
+    /** Everything that processes samples, instantiated once per supported sample type. */
+    template <typename SampleType>
+    struct ProcessingChain
+    {
+        BiquadCascade<SampleType> cascade;
+        DynamicsDetector<SampleType> detector;
+        juce::dsp::Gain<SampleType> outputGain;
+        juce::dsp::Gain<SampleType> autoGain;
+        std::unique_ptr<juce::dsp::Oversampling<SampleType>> oversampling;
+    };
+
+    /** Slots of the per band parameters in BandParameters and in the pulled values. */
+    enum BandParameter
+    {
+        TypeParameter = 0,
+        FrequencyParameter,
+        QualityParameter,
+        GainParameter,
+        ActiveParameter,
+        DynamicParameter,
+        ThresholdParameter,
+        RatioParameter,
+        AttackParameter,
+        ReleaseParameter,
+        SidechainParameter,
+        RoutingParameter,
+        numBandParameters
+    };
+    using BandParameters = std::array<std::atomic<float>*, numBandParameters>;
+    using BandValues = std::array<float, numBandParameters>;
+
+    /** Output, oversampling, oversampling filter, design, phase, morph and auto gain, stored after the band records. */
+    static constexpr size_t numGlobalStateParameters = 7;
+
+    /** Band values and output gain held by a snapshot slot. */
+    struct Snapshot
+    {
+        bool valid = false;
+        std::array<BandValues, maxNumBands> bands{};
+        float output = 1.0f;
+    };
+    using SnapshotBank = std::array<Snapshot, size_t(numSnapshots)>;
+
+    void addParameterTarget(const juce::String& parameterID, int band, ParameterField field);
+    void parameterChanged(const ParameterTarget& target, float newValue);
+    /** Restores a state written by getStateInformation(), returning false if it is not one. */
+    bool setBinaryState(const void* data, int sizeInBytes);
+    Snapshot captureSnapshot() const;
+    void writeSnapshot(juce::OutputStream& stream, const Snapshot& snapshot) const;
+    static void readSnapshot(juce::InputStream& stream, Snapshot& snapshot, size_t numBands, size_t numFields);
+    /** Brings the morph settings up to date, returning true if the settings the cascade should run changed. */
+    bool updateMorph() noexcept;
+    static void morphBandValues(const BandValues& a, const BandValues& b, float morph, BandValues& result) noexcept;
+    void designBandsFromValues(BiquadCascadeSettings& settings, const std::vector<BandValues>& values, juce::uint32 bands) const noexcept;
+    void pullParameters() noexcept;
+    template <typename SampleType>
+    void prepareChain(ProcessingChain<SampleType>& chain, const juce::dsp::ProcessSpec& spec, bool linearPhase);
+    template <typename SampleType>
+    void process(juce::AudioBuffer<SampleType>& buffer, ProcessingChain<SampleType>& chain) noexcept;
+    template <typename SampleType>
+    void processFilters(juce::dsp::AudioBlock<SampleType> block, ProcessingChain<SampleType>& chain) noexcept;
+    template <typename SampleType>
+    void processAutomated(juce::dsp::AudioBlock<SampleType> block, ProcessingChain<SampleType>& chain) noexcept;
+    juce::uint32 applyParameterEvent(const ParameterEvent& event, float& output) noexcept;
+    /** Returns the BandParameter slot of a field that follows events sample accurately, -1 for the others. */
+    static int getBandParameterSlot(ParameterField field) noexcept;
+    template <typename SampleType>
+    void updateDynamics(juce::AudioBuffer<SampleType>& buffer, ProcessingChain<SampleType>& chain,
+                        const BiquadCascadeSettings& settings, const std::vector<BandValues>& values, bool settingsChanged) noexcept;
+    BiquadCoefficients designBandFromValues(size_t index, const BandValues& values, double sampleRate, bool matched) const noexcept;
+    static BiquadCoefficients designBand(FilterType type, double sampleRate, double frequency, double quality, double gain, bool matched) noexcept;
+    template <typename SampleType>
+    void updateAutoGain(ProcessingChain<SampleType>& chain) noexcept;
+    template <typename SampleType>
+    bool updateSilence(const juce::AudioBuffer<SampleType>& buffer) noexcept;
+    void designPendingBands();
     void updateBand(const size_t index);
     void updateBypassedStates();
+    static bool isUnity(const Band& band);
+    static bool isUnity(FilterType type, float gain, bool dynamic) noexcept;
     void updatePlots();
+    void updateTailLength();
+    void updateLinearPhaseKernel();
+    void applyMatch();
+    void handleAsyncUpdate() override;
 
     juce::AudioProcessorValueTreeState _parameters;
     juce::UndoManager _undo;
 
+    std::vector<ParameterTarget> _parameterTargets;
+    std::vector<BandParameters> _bandParameters;
+    /** The parameters in the order of the binary state. */
+    std::vector<juce::RangedAudioParameter*> _stateParameters;
+    std::atomic<float>* _outputParameter = nullptr;
+    std::atomic<float>* _oversamplingParameter = nullptr;
+    std::atomic<float>* _oversamplingFilterParameter = nullptr;
+    std::atomic<float>* _designParameter = nullptr;
+    std::atomic<float>* _phaseParameter = nullptr;
+    std::atomic<float>* _morphParameter = nullptr;
+    std::atomic<float>* _autoGainParameter = nullptr;
+    // Owned by the design thread, see Band.
     std::vector<Band> _bands;
     std::vector<double> _frequencies;
-    std::vector<double> _magnitudes;
 
-    double _sampleRate = 0;
-    int _soloedBand = -1;
+    // Response curves, only touched where bands are designed: the evaluator for the plot
+    // frequencies at the current rate, the sum of the curves of the bands that are shown,
+    // which bands that sum holds, and a version per band curve.
+    ResponseEvaluator _responseEvaluator;
+    std::vector<double> _summedResponse;
+    juce::uint32 _summedBands = 0;
+    std::vector<juce::uint32> _bandVersions;
+
+    // The rate the bands are designed for, which is the oversampled rate when oversampling is on.
+    std::atomic<double> _sampleRate{ 0 };
+    size_t _oversamplingOrder = 0;
+
+    // Kernel length per entry of getPhaseNames(), 0 for the minimum phase cascade.
+    static constexpr std::array<size_t, 3> linearPhaseLengths{ 0, 4096, 16384 };
+    size_t _linearPhaseLength = 0;
+    std::atomic<int> _soloedBand{ -1 };
     bool _wasBypassed = true;
+    std::atomic<bool> _prepareDirty{ false };   ///< A latency setting changed, see handleAsyncUpdate().
+
+    // Tail of the current settings, from the design thread: in seconds for the host, and in
+    // samples at the host rate for the silence detection.
+    std::atomic<double> _tailLengthSeconds{ 0 };
+    std::atomic<int> _tailSamples{ 0 };
+    static constexpr double maxTailSeconds = 30.0;
+
+    // Silence detection on the audio thread: once the input has been silent for longer
+    // than the tail and the latency, the output is silent as well and nothing is run.
+    static constexpr float silenceThreshold = 1.0e-6f;  // -120 dB, the level the tail decays to.
+    int _silentSamples = 0;
+    bool _sleeping = false;
+
+    // Bands whose parameters changed since the design thread last looked, one bit per band,
+    // set from the parameter listeners and from the per block pull on the audio thread.
+    std::atomic<juce::uint32> _dirtyBands{ 0 };
+    std::atomic<bool> _plotsDirty{ false };
+
+    // Parameter values seen by the previous block, only touched on the audio thread.
+    std::vector<BandValues> _pulledValues;
+    float _pulledOutput = 1.0f;
+
+    // Sample accurate automation: events for the next block, and on the audio thread the
+    // events of the current block, the values in effect at the current position within it
+    // and the cascade settings designed from them.
+    static constexpr size_t maxParameterEvents = 1024;
+    ParameterEventQueue<maxParameterEvents> _parameterEvents;
+    std::array<ParameterEvent, maxParameterEvents> _blockEvents;
+    std::vector<BandValues> _eventValues;
+    float _eventOutput = 1.0f;
+    BiquadCascadeSettings _automatedSettings;
 
-    using FilterBand = juce::dsp::ProcessorDuplicator<juce::dsp::IIR::Filter<float>, juce::dsp::IIR::Coefficients<float>>;
-    using Gain = juce::dsp::Gain<float>;
-    juce::dsp::ProcessorChain<FilterBand, FilterBand, FilterBand, FilterBand, FilterBand, FilterBand, Gain> _filterChain;
+    // Dynamic bands, only touched on the audio thread: the detectors whose settings need to
+    // be set again, the bands run dynamically in the last block with their gain reductions
+    // in dB, and the cascade settings with those applied, handed to the cascade with a ramp
+    // over each block.
+    juce::uint32 _detectorsDirty = ~juce::uint32(0);
+    juce::uint32 _dynamicBands = 0;
+    std::array<float, maxNumBands> _dynamicReductions{};
+    BiquadCascadeSettings _dynamicSettings;
+    static constexpr float maxDynamicReductionDecibels = 24.0f;
+
+    // Snapshots: the message thread edits _snapshots and publishes a copy. While a pair of
+    // slots is engaged, the audio thread renders the interpolated values and settings
+    // instead of the pulled ones, redesigning only the bands whose values moved.
+    SnapshotBank _snapshots;
+    LockFreeTripleBuffer<SnapshotBank> _publishedSnapshots;
+    std::atomic<int> _morphSlots{ -1 };   ///< slotA + numSnapshots * slotB, or -1.
+    std::vector<BandValues> _morphValues;
+    float _morphOutput = 1.0f;
+    int _morphConfiguration = -1;
+    bool _morphing = false;
+    BiquadCascadeSettings _morphSettings;
+
+    // Only the chain matching getProcessingPrecision() is prepared and run.
+    ProcessingChain<float> _floatChain;
+    ProcessingChain<double> _doubleChain;
+
+    // The design thread edits _cascadeSettings and publishes a copy, the audio thread picks
+    // up the newest copy at the start of the next block.
+    BiquadCascadeSettings _cascadeSettings;
+    LockFreeTripleBuffer<BiquadCascadeSettings> _pendingSettings;
+    LockFreeTripleBuffer<PlotData> _plotData;
+    DesignThread _designThread{ *this };
+
+    // Band designs and curves by quantised settings, only used where bands are designed.
+    CoefficientCache _coefficientCache;
+
+    // Linear phase mode: the design thread turns the band response into a symmetric FIR,
+    // the convolver crossfades to each new kernel on the audio thread.
+    UniformPartitionedConvolver _convolver;
+    std::unique_ptr<juce::dsp::FFT> _kernelFFT;
+    std::vector<float> _kernelBuffer, _kernelWindow, _kernel;
+    bool _kernelDirty = false;
 
     Analyser<float> _inputAnalyser;
     Analyser<float> _outputAnalyser;
 
+    // Loudness of the input and of the filtered signal, and the gain in dB that auto gain
+    // applies after the output gain, ramped over autoGainRampSeconds.
+    LoudnessMeter _inputMeter;
+    LoudnessMeter _filteredMeter;
+    float _autoGainDecibels = 0.0f;
+    static constexpr float maxAutoGainDecibels = 24.0f;
+    static constexpr double autoGainRampSeconds = 0.1;
+
+    // Match EQ, set up on the message thread: the spectrum being captured or -1, the
+    // captured spectra on the plot frequencies, and the fit jobs writing one result each.
+    // The pool is created with the first fit.
+    static constexpr double matchSmoothingOctaves = 1.0 / 3.0;
+    static constexpr double matchRangeDecibels = 80.0;  // Below the loudest point, a spectrum is left out of the fit.
+    std::atomic<int> _matchCapture{ -1 };
+    std::array<std::vector<double>, 2> _matchSpectra;
+    std::vector<MatchFitter::Result> _matchResults;
+    std::atomic<int> _pendingMatchJobs{ 0 };
+    std::atomic<bool> _matchFinished{ false };
+    double _matchError = 0.0;
+    std::unique_ptr<juce::ThreadPool> _matchPool;
+
     juce::Point<int> _editorSize = { 900, 500 };
+    std::atomic<bool> _editorOpen{ false };     ///< For the audio thread, as getActiveEditor() locks.
+    size_t _lastStateNumBands = 0;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ParametricEqualiserProcessor)
 
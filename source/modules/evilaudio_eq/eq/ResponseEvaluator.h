@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstring>
+#include <vector>
+
+#include "juce_dsp/juce_dsp.h"
+#include "BiquadCoefficients.h"
+
+/**
+ *  Magnitude responses of second order sections on a fixed grid of frequencies, for the
+ *  response curves of the editor.
+ *
+ *  Uses the same form as BiquadCoefficients::getMagnitudeForFrequency(), in which only
+ *  phi0 = cos^2(w/2), phi1 = sin^2(w/2) and phi2 = 4 phi0 phi1 depend on the frequency.
+ *  Those are computed once per grid and sample rate, so a section costs two quadratic forms
+ *  and a logarithm per point and no trigonometry. The quadratic forms run on the lanes of a
+ *  juce::dsp::SIMDRegister, the logarithm is a branch-free polynomial that compilers
+ *  vectorise.
+ *
+ *  Curves are log2 of the magnitude, so the curve of a cascade is the sum of the curves of
+ *  its sections, and a section can be taken out again by subtracting its curve. Values are
+ *  clamped to minLogMagnitude, which keeps the zeros of notches and pass filters finite.
+ */
+class ResponseEvaluator
+{
+public:
+    using Vector = juce::dsp::SIMDRegister<double>;
+
+    static constexpr size_t numLanes = Vector::SIMDNumElements;
+    static constexpr double minLogMagnitude = -40.0;    // About -240 dB.
+
+    /** Precomputes the frequency terms of a grid. Not for the audio thread. */
+    void prepare(const std::vector<double>& frequencies, double sampleRate)
+    {
+        _numPoints = frequencies.size();
+        const auto numVectors = (_numPoints + numLanes - 1) / numLanes;
+
+        // Padding lanes evaluate DC, which every section handles.
+        _phi0.assign(numVectors, Vector::expand(1.0));
+        _phi1.assign(numVectors, Vector::expand(0.0));
+        _phi2.assign(numVectors, Vector::expand(0.0));
+        _numerators.assign(numVectors, Vector::expand(0.0));
+        _denominators.assign(numVectors, Vector::expand(0.0));
+
+        auto* phi0 = reinterpret_cast<double*>(_phi0.data());
+        auto* phi1 = reinterpret_cast<double*>(_phi1.data());
+        auto* phi2 = reinterpret_cast<double*>(_phi2.data());
+        for (size_t i = 0; i < _numPoints; ++i)
+        {
+            const auto s = std::sin(juce::MathConstants<double>::pi * frequencies[i] / sampleRate);
+            phi1[i] = s * s;
+            phi0[i] = 1.0 - phi1[i];
+            phi2[i] = 4.0 * phi0[i] * phi1[i];
+        }
+    }
+
+    size_t getNumPoints() const noexcept
+    {
+        return _numPoints;
+    }
+
+    /** Writes log2 of the magnitude of a section at each point into dest, which holds getNumPoints() values. */
+    void process(const BiquadCoefficients& section, double* dest) noexcept
+    {
+        const auto n0 = Vector::expand(juce::square(section.b0 + section.b1 + section.b2));
+        const auto n1 = Vector::expand(juce::square(section.b0 - section.b1 + section.b2));
+        const auto n2 = Vector::expand(-4.0 * section.b0 * section.b2);
+        const auto d0 = Vector::expand(juce::square(1.0 + section.a1 + section.a2));
+        const auto d1 = Vector::expand(juce::square(1.0 - section.a1 + section.a2));
+        const auto d2 = Vector::expand(-4.0 * section.a2);
+
+        for (size_t v = 0; v < _phi0.size(); ++v)
+        {
+            _numerators[v] = (n0 * _phi0[v]) + (n1 * _phi1[v]) + (n2 * _phi2[v]);
+            _denominators[v] = (d0 * _phi0[v]) + (d1 * _phi1[v]) + (d2 * _phi2[v]);
+        }
+
+        // The floors keep |H|^2 a normal number for the logarithm, whose result is clamped
+        // afterwards. Clamping |H|^2 instead would let compilers branch around the logarithm,
+        // which keeps them from vectorising the loop.
+        const auto* numerators = reinterpret_cast<const double*>(_numerators.data());
+        const auto* denominators = reinterpret_cast<const double*>(_denominators.data());
+        const auto floor = std::exp2(2.0 * minLogMagnitude);
+        for (size_t i = 0; i < _numPoints; ++i)
+        {
+            const auto squared = juce::jmax(numerators[i], floor * floor) / juce::jmax(denominators[i], floor);
+            dest[i] = juce::jmax(0.5 * log2(squared), minLogMagnitude);
+        }
+    }
+
+private:
+    /**
+     *  log2 for positive normal numbers, to about 1e-10. The mantissa is brought into
+     *  [sqrt(1/2), sqrt(2)), where the atanh series of the natural logarithm converges fast.
+     */
+    static double log2(double x) noexcept
+    {
+        juce::uint64 bits;
+        std::memcpy(&bits, &x, sizeof(bits));
+
+        // Mantissas above sqrt(2) are halved and their exponent goes up by one. The carry out
+        // of the mantissa field makes that comparison, without a 64 bit compare that SSE2 lacks.
+        const auto mantissaField = bits & 0x000fffffffffffffull;
+        const auto high = (mantissaField + (0x000fffffffffffffull - 0x0006a09e667f3bcdull)) >> 52;
+
+        // The biased exponent becomes the low bits of 2^52 + exponent, which converts it
+        // without an integer to double conversion that SIMD units lack for 64 bits.
+        const auto exponentBits = ((bits >> 52) + high) | 0x4330000000000000ull;
+        const auto mantissaBits = mantissaField | ((0x3ffull - high) << 52);
+
+        double exponent, mantissa;
+        std::memcpy(&exponent, &exponentBits, sizeof(exponent));
+        std::memcpy(&mantissa, &mantissaBits, sizeof(mantissa));
+        exponent -= 4503599627370496.0 + 1023.0;
+
+        const auto s = (mantissa - 1.0) / (mantissa + 1.0);
+        const auto s2 = s * s;
+        const auto ln = s * (2.0 + s2 * (2.0 / 3.0 + s2 * (2.0 / 5.0 + s2 * (2.0 / 7.0 + s2 * (2.0 / 9.0 + s2 * (2.0 / 11.0))))));
+        return exponent + ln * 1.4426950408889634;  // 1 / ln(2)
+    }
+
+    size_t _numPoints = 0;
+    std::vector<Vector> _phi0, _phi1, _phi2;
+    std::vector<Vector> _numerators, _denominators;
+};
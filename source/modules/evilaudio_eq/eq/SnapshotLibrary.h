@@ -0,0 +1,92 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+/**
+ *  Read-only view of a snapshot library file, mapped into memory.
+ *
+ *  A library is a header followed by fixed-size records of 32 bit floats, one per snapshot:
+ *  numBands records of numFields band values, then the output gain. As every record has the
+ *  same size, any snapshot is found without reading the ones before it, and the operating
+ *  system only pages in the records that are actually opened, however large the file is.
+ *
+ *  Files are written with writeHeader() followed by the records, in the byte order of
+ *  juce::OutputStream::writeFloat().
+ */
+class SnapshotLibrary
+{
+public:
+    static constexpr int magic = 0x4c534145;    // "EASL" in the byte order of the stream.
+    static constexpr int version = 1;
+    static constexpr size_t headerSize = 5 * sizeof(juce::int32);
+
+    explicit SnapshotLibrary(const juce::File& file)
+        : _file(file, juce::MemoryMappedFile::readOnly)
+    {
+        if (_file.getData() == nullptr || _file.getSize() < headerSize)
+            return;
+
+        juce::MemoryInputStream header(_file.getData(), headerSize, false);
+        if (header.readInt() != magic || header.readInt() > version)
+            return;
+
+        _numBands = size_t(juce::jmax(0, header.readInt()));
+        _numFields = size_t(juce::jmax(0, header.readInt()));
+        _numSnapshots = size_t(juce::jmax(0, header.readInt()));
+
+        // A truncated file keeps the records that are complete.
+        _numSnapshots = juce::jmin(_numSnapshots, (_file.getSize() - headerSize) / getRecordSize());
+    }
+
+    bool isValid() const noexcept
+    {
+        return _numSnapshots > 0;
+    }
+
+    size_t getNumSnapshots() const noexcept
+    {
+        return _numSnapshots;
+    }
+
+    size_t getNumBands() const noexcept
+    {
+        return _numBands;
+    }
+
+    size_t getNumFields() const noexcept
+    {
+        return _numFields;
+    }
+
+    /** Returns the size of a record in bytes. */
+    size_t getRecordSize() const noexcept
+    {
+        return (_numBands * _numFields + 1) * sizeof(float);
+    }
+
+    /** Returns the start of a record inside the mapped file, or nullptr if there is no such snapshot. */
+    const void* getRecord(size_t index) const noexcept
+    {
+        if (index >= _numSnapshots)
+            return nullptr;
+        return static_cast<const char*>(_file.getData()) + headerSize + index * getRecordSize();
+    }
+
+    /** Writes the header of a library of numSnapshots records. */
+    static bool writeHeader(juce::OutputStream& stream, size_t numBands, size_t numFields, size_t numSnapshots)
+    {
+        return stream.writeInt(magic)
+            && stream.writeInt(version)
+            && stream.writeInt(int(numBands))
+            && stream.writeInt(int(numFields))
+            && stream.writeInt(int(numSnapshots));
+    }
+
+private:
+    juce::MemoryMappedFile _file;
+    size_t _numBands = 0;
+    size_t _numFields = 0;
+    size_t _numSnapshots = 0;
+
+    JUCE_DECLARE_NON_COPYABLE(SnapshotLibrary)
+};
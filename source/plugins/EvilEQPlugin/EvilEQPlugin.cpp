@@ -1,7 +1,37 @@
 #include <JuceHeader.h>
 
-// This creates new instances of the plugin..
+/**
+ *  Returns the band count of the state the standalone wrapper restores after creating the
+ *  processor. It keeps the state as base64 in the "filterState" value of the settings file
+ *  below, which uses the options of juce_StandaloneFilterApp.cpp. Hosts of the other formats
+ *  hand the state over later, getLastStateNumBands() then tells whether its bands fit.
+ */
+static size_t getSavedNumBands()
+{
+   #if JucePlugin_Build_Standalone
+    if (juce::PluginHostType::getPluginLoadedAs() == juce::AudioProcessor::wrapperType_Standalone)
+    {
+        juce::PropertiesFile::Options options;
+        options.applicationName = JucePlugin_Name;
+        options.filenameSuffix = ".settings";
+        options.osxLibrarySubFolder = "Application Support";
+       #if JUCE_LINUX || JUCE_BSD
+        options.folderName = "~/.config";
+       #else
+        options.folderName = "";
+       #endif
+
+        juce::PropertiesFile settings(options);
+        juce::MemoryBlock state;
+        if (state.fromBase64Encoding(settings.getValue("filterState")) && !state.isEmpty())
+            return ParametricEqualiserProcessor::getNumBandsFromState(state.getData(), static_cast<int>(state.getSize()));
+    }
+   #endif
+    return ParametricEqualiserProcessor::defaultNumBands;
+}
+
+// This creates new instances of the plugin, with as many bands as the saved state holds.
 juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
 {
-    return new ParametricEqualiserProcessor();
+    return new ParametricEqualiserProcessor(getSavedNumBands());
 }
@@ -0,0 +1,26 @@
+#include <JuceHeader.h>
+
+/**
+ *  Runs the unit tests of the EvilAudio modules and returns 1 if any of them failed.
+ *
+ *  A category can be given on the command line to run only that one.
+ */
+int main(int argc, char* argv[])
+{
+    // The processors start timers and async updates, which need a message manager.
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::UnitTestRunner runner;
+    runner.setAssertOnFailure(false);
+
+    if (argc > 1)
+        runner.runTestsInCategory(argv[1]);
+    else
+        runner.runTestsInCategory("EvilAudio");
+
+    auto numFailures = 0;
+    for (auto i = 0; i < runner.getNumResults(); ++i)
+        numFailures += runner.getResult(i)->failures;
+
+    return numFailures > 0 ? 1 : 0;
+}
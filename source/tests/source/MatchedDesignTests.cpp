@@ -0,0 +1,202 @@
+#include <JuceHeader.h>
+
+namespace
+{
+    using Prototype = MatchedBiquadDesign::AnalogPrototype;
+
+    const std::initializer_list<double> qualities { 0.5, 0.7, 1.0, 1.4, 2.0, 4.0, 8.0 };
+    const std::initializer_list<double> gainsInDecibels { -18.0, -12.0, -6.0, -3.0, 3.0, 6.0, 12.0, 18.0 };
+
+    double toDecibels(double magnitude)
+    {
+        return 20.0 * std::log10(magnitude);
+    }
+
+    /**
+     *  The largest magnitude error in dB against the analog prototype, on the 300 point grid the
+     *  processor plots its bands on, from the given frequency up to Nyquist.
+     */
+    double getMaxError(const BiquadCoefficients& coefficients, const Prototype& prototype,
+                       double sampleRate, double frequency, double from = 0.0)
+    {
+        auto maxError = 0.0;
+        for (auto i = 0; i < 300; ++i)
+        {
+            const auto f = 20.0 * std::pow(2.0, i / 30.0);
+            if (f >= 0.5 * sampleRate)
+                break;
+            if (f < from)
+                continue;
+
+            const auto error = toDecibels(coefficients.getMagnitudeForFrequency(f, sampleRate))
+                             - toDecibels(prototype.getMagnitude(f / frequency));
+            maxError = juce::jmax(maxError, std::abs(error));
+        }
+        return maxError;
+    }
+
+    double getError(const BiquadCoefficients& coefficients, const Prototype& prototype,
+                    double sampleRate, double frequency, double at)
+    {
+        return std::abs(toDecibels(coefficients.getMagnitudeForFrequency(at, sampleRate))
+                      - toDecibels(prototype.getMagnitude(at / frequency)));
+    }
+
+    /** Calls the function for band frequencies from 20 Hz up to the given one, six per octave. */
+    template <typename Function>
+    void forEachFrequency(double maxFrequency, Function&& function)
+    {
+        for (auto i = 0;; ++i)
+        {
+            const auto frequency = 20.0 * std::pow(2.0, i / 6.0);
+            if (frequency > maxFrequency * 1.0001)
+                break;
+            function(frequency);
+        }
+    }
+}
+
+class MatchedDesignTests : public juce::UnitTest
+{
+public:
+    MatchedDesignTests() : juce::UnitTest("Matched biquad design", "EvilAudio") {}
+
+    void runTest() override
+    {
+        beginTest("Peaks are exact at DC and at the band frequency");
+        {
+            auto maxError = 0.0;
+            for (auto sampleRate : { 44100.0, 48000.0, 96000.0 })
+                forEachFrequency(16000.0, [&](double frequency)
+                {
+                    for (auto Q : qualities)
+                        for (auto dB : gainsInDecibels)
+                        {
+                            const auto gain = juce::Decibels::decibelsToGain(dB);
+                            const auto prototype = Prototype::peak(Q, gain);
+                            const auto design = MatchedBiquadDesign::makePeakFilter(sampleRate, frequency, Q, gain);
+                            maxError = juce::jmax(maxError,
+                                                  getError(design, prototype, sampleRate, frequency, 0.01),
+                                                  getError(design, prototype, sampleRate, frequency, frequency));
+                        }
+                });
+            expectLessThan(maxError, 1.0e-3);
+        }
+
+        beginTest("Peaks follow the analog prototype up to Nyquist");
+        {
+            // Q of 1 and above and up to 12 dB of boost or cut; wider or deeper peaks high up
+            // lose up to 2.4 dB at 44.1 kHz near Nyquist.
+            expectPeakError(44100.0, 4000.0, 0.25);
+            expectPeakError(48000.0, 4000.0, 0.25);
+            expectPeakError(44100.0, 8000.0, 1.0);
+            expectPeakError(48000.0, 8000.0, 1.0);
+            expectPeakError(96000.0, 16000.0, 0.1);
+        }
+
+        beginTest("Peaks are closer to the analog prototype than the bilinear designs above the band frequency");
+        {
+            auto numCloser = 0, numCases = 0;
+            for (auto sampleRate : { 44100.0, 48000.0 })
+                for (auto frequency : { 4000.0, 8000.0, 12000.0, 16000.0 })
+                    for (auto Q : qualities)
+                        for (auto dB : gainsInDecibels)
+                        {
+                            const auto gain = juce::Decibels::decibelsToGain(dB);
+                            const auto prototype = Prototype::peak(Q, gain);
+                            const auto matched = MatchedBiquadDesign::makePeakFilter(sampleRate, frequency, Q, gain);
+                            const auto bilinear = BilinearBiquadDesign::makePeakFilter(sampleRate, frequency, Q, gain);
+
+                            ++numCases;
+                            if (getMaxError(matched, prototype, sampleRate, frequency, frequency)
+                                < getMaxError(bilinear, prototype, sampleRate, frequency, frequency))
+                                ++numCloser;
+                        }
+            expectEquals(numCloser, numCases);
+        }
+
+        beginTest("Shelves are exact at DC and at Nyquist");
+        {
+            auto maxError = 0.0;
+            for (auto sampleRate : { 44100.0, 48000.0, 96000.0 })
+                forEachFrequency(16000.0, [&](double frequency)
+                {
+                    for (auto Q : qualities)
+                        for (auto dB : gainsInDecibels)
+                        {
+                            const auto gain = juce::Decibels::decibelsToGain(dB);
+                            const auto lowShelf = Prototype::lowShelf(Q, gain);
+                            const auto highShelf = Prototype::highShelf(Q, gain);
+                            const auto lowDesign = MatchedBiquadDesign::makeLowShelf(sampleRate, frequency, Q, gain);
+                            const auto highDesign = MatchedBiquadDesign::makeHighShelf(sampleRate, frequency, Q, gain);
+
+                            for (auto at : { 0.01, 0.5 * sampleRate })
+                                maxError = juce::jmax(maxError,
+                                                      getError(lowDesign, lowShelf, sampleRate, frequency, at),
+                                                      getError(highDesign, highShelf, sampleRate, frequency, at));
+                        }
+                });
+            expectLessThan(maxError, 1.0e-3);
+        }
+
+        beginTest("Shelves follow the analog prototype up to Nyquist");
+        {
+            // Q of 1 and below and up to 12 dB of boost or cut. Resonant shelves are not matched
+            // at their resonance and drift by several dB once it gets close to Nyquist.
+            expectShelfError(44100.0, 16000.0, 1.1);
+            expectShelfError(48000.0, 16000.0, 1.1);
+            expectShelfError(44100.0, 8000.0, 0.4);
+            expectShelfError(96000.0, 16000.0, 0.4);
+        }
+    }
+
+private:
+    void expectPeakError(double sampleRate, double maxFrequency, double tolerance)
+    {
+        auto maxError = 0.0;
+        forEachFrequency(maxFrequency, [&](double frequency)
+        {
+            for (auto Q : qualities)
+                for (auto dB : gainsInDecibels)
+                {
+                    if (Q < 1.0 || std::abs(dB) > 12.0)
+                        continue;
+
+                    const auto gain = juce::Decibels::decibelsToGain(dB);
+                    maxError = juce::jmax(maxError, getMaxError(MatchedBiquadDesign::makePeakFilter(sampleRate, frequency, Q, gain),
+                                                                Prototype::peak(Q, gain), sampleRate, frequency));
+                }
+        });
+
+        logMessage("Peaks up to " + juce::String(maxFrequency) + " Hz at " + juce::String(sampleRate) + " Hz: "
+                   + juce::String(maxError, 3) + " dB");
+        expectLessThan(maxError, tolerance);
+    }
+
+    void expectShelfError(double sampleRate, double maxFrequency, double tolerance)
+    {
+        auto maxError = 0.0;
+        forEachFrequency(maxFrequency, [&](double frequency)
+        {
+            for (auto Q : qualities)
+                for (auto dB : gainsInDecibels)
+                {
+                    if (Q > 1.0 || std::abs(dB) > 12.0)
+                        continue;
+
+                    const auto gain = juce::Decibels::decibelsToGain(dB);
+                    maxError = juce::jmax(maxError,
+                                          getMaxError(MatchedBiquadDesign::makeLowShelf(sampleRate, frequency, Q, gain),
+                                                      Prototype::lowShelf(Q, gain), sampleRate, frequency),
+                                          getMaxError(MatchedBiquadDesign::makeHighShelf(sampleRate, frequency, Q, gain),
+                                                      Prototype::highShelf(Q, gain), sampleRate, frequency));
+                }
+        });
+
+        logMessage("Shelves up to " + juce::String(maxFrequency) + " Hz at " + juce::String(sampleRate) + " Hz: "
+                   + juce::String(maxError, 3) + " dB");
+        expectLessThan(maxError, tolerance);
+    }
+};
+
+static MatchedDesignTests matchedDesignTests;
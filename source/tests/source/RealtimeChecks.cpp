@@ -0,0 +1,142 @@
+#include "RealtimeChecks.h"
+
+#if JUCE_LINUX
+ #include <dlfcn.h>
+ #include <pthread.h>
+#endif
+
+#if JUCE_LINUX && defined (__GLIBC__)
+ #define EVILAUDIO_COUNT_ALLOCATIONS 1
+#else
+ #define EVILAUDIO_COUNT_ALLOCATIONS 0
+#endif
+
+#if EVILAUDIO_COUNT_ALLOCATIONS
+ #include <cerrno>
+ #include <malloc.h>
+#endif
+
+namespace
+{
+    thread_local bool isAudioThread = false;
+    std::atomic<juce::int64> numLocks { 0 };
+    std::atomic<juce::int64> numAllocations { 0 };
+
+    void countAllocation() noexcept
+    {
+        if (isAudioThread)
+            numAllocations.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+#if JUCE_LINUX
+// The executable's definition comes first in the lookup order, so JUCE, the standard library
+// and the modules all lock through here; the real function is looked up behind it.
+extern "C" int pthread_mutex_lock(pthread_mutex_t* mutex)
+{
+    using Function = int (*)(pthread_mutex_t*);
+    static const auto next = reinterpret_cast<Function>(dlsym(RTLD_NEXT, "pthread_mutex_lock"));
+
+    if (isAudioThread)
+        numLocks.fetch_add(1, std::memory_order_relaxed);
+
+    return next(mutex);
+}
+#endif
+
+#if EVILAUDIO_COUNT_ALLOCATIONS
+// The same for the heap: operator new, std::malloc and the aligned variants all allocate through
+// these. glibc exports its own implementations under the __libc_ names, which also avoids dlsym,
+// as that allocates itself.
+extern "C"
+{
+    void* __libc_malloc(size_t size);
+    void* __libc_calloc(size_t count, size_t size);
+    void* __libc_realloc(void* pointer, size_t size);
+    void* __libc_memalign(size_t alignment, size_t size);
+
+    void* malloc(size_t size) noexcept
+    {
+        countAllocation();
+        return __libc_malloc(size);
+    }
+
+    void* calloc(size_t count, size_t size) noexcept
+    {
+        countAllocation();
+        return __libc_calloc(count, size);
+    }
+
+    void* realloc(void* pointer, size_t size) noexcept
+    {
+        countAllocation();
+        return __libc_realloc(pointer, size);
+    }
+
+    void* memalign(size_t alignment, size_t size) noexcept
+    {
+        countAllocation();
+        return __libc_memalign(alignment, size);
+    }
+
+    void* aligned_alloc(size_t alignment, size_t size) noexcept
+    {
+        countAllocation();
+        return __libc_memalign(alignment, size);
+    }
+
+    int posix_memalign(void** result, size_t alignment, size_t size) noexcept
+    {
+        countAllocation();
+        *result = __libc_memalign(alignment, size);
+        return *result != nullptr ? 0 : ENOMEM;
+    }
+}
+#endif
+
+namespace RealtimeChecks
+{
+    ScopedAudioThread::ScopedAudioThread() noexcept
+    {
+        isAudioThread = true;
+    }
+
+    ScopedAudioThread::~ScopedAudioThread() noexcept
+    {
+        isAudioThread = false;
+    }
+
+    bool canCountLocks() noexcept
+    {
+       #if JUCE_LINUX
+        return true;
+       #else
+        return false;
+       #endif
+    }
+
+    juce::int64 getNumLocks() noexcept
+    {
+        return numLocks.load(std::memory_order_relaxed);
+    }
+
+    bool canCountAllocations() noexcept
+    {
+       #if EVILAUDIO_COUNT_ALLOCATIONS
+        return true;
+       #else
+        return false;
+       #endif
+    }
+
+    juce::int64 getNumAllocations() noexcept
+    {
+        return numAllocations.load(std::memory_order_relaxed);
+    }
+
+    void reset() noexcept
+    {
+        numLocks = 0;
+        numAllocations = 0;
+    }
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+ *  Counts what a thread does that it must not do on the audio thread.
+ *
+ *  Code run inside a ScopedAudioThread is watched: every pthread mutex it locks and every
+ *  heap allocation it makes is counted. The counting works by interposing pthread_mutex_lock
+ *  and the allocation functions of the C library, which new and delete also end up in, so it
+ *  is only available on Linux (and for allocations, with glibc); elsewhere canCountLocks()
+ *  and canCountAllocations() return false and the counters stay at zero.
+ */
+namespace RealtimeChecks
+{
+    /** Marks the calling thread as an audio thread for as long as the object lives. */
+    struct ScopedAudioThread
+    {
+        ScopedAudioThread() noexcept;
+        ~ScopedAudioThread() noexcept;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedAudioThread)
+    };
+
+    bool canCountLocks() noexcept;
+
+    /** Returns the number of mutexes locked on audio threads since the last reset(). */
+    juce::int64 getNumLocks() noexcept;
+
+    bool canCountAllocations() noexcept;
+
+    /** Returns the number of heap allocations made on audio threads since the last reset(). */
+    juce::int64 getNumAllocations() noexcept;
+
+    void reset() noexcept;
+}
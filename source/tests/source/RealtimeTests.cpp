@@ -0,0 +1,220 @@
+#include "RealtimeChecks.h"
+#include "TestSignals.h"
+
+#include <thread>
+
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 64;
+
+    /** Returns the parameters that can change while the processor runs, which are all but the latency ones. */
+    juce::Array<juce::AudioProcessorParameter*> getRuntimeParameters(juce::AudioProcessor& processor)
+    {
+        juce::Array<juce::AudioProcessorParameter*> parameters;
+        for (auto* parameter : processor.getParameters())
+            if (auto* withID = dynamic_cast<juce::AudioProcessorParameterWithID*>(parameter);
+                withID != nullptr && !ParametricEqualiserProcessor::isLatencyParameter(withID->paramID))
+                parameters.add(parameter);
+        return parameters;
+    }
+}
+
+class RealtimeTests : public juce::UnitTest
+{
+public:
+    RealtimeTests() : juce::UnitTest("Realtime safety", "EvilAudio") {}
+
+    void runTest() override
+    {
+        if (RealtimeChecks::canCountLocks())
+            runLockTests();
+        else
+            logMessage("Locks can only be counted on Linux, skipping the lock tests.");
+
+        if (RealtimeChecks::canCountAllocations())
+            runAllocationTests();
+        else
+            logMessage("Allocations can only be counted on Linux with glibc, skipping the allocation tests.");
+    }
+
+private:
+    void runLockTests()
+    {
+        beginTest("Locking a mutex on an audio thread is counted");
+        {
+            juce::CriticalSection lock;
+            RealtimeChecks::reset();
+            {
+                RealtimeChecks::ScopedAudioThread audioThread;
+                const juce::ScopedLock scopedLock(lock);
+            }
+            expectGreaterThan(RealtimeChecks::getNumLocks(), juce::int64(0));
+        }
+
+        beginTest("The audio thread never locks while parameters change on another thread");
+        {
+            constexpr int numBlocks = 20000;
+
+            ParametricEqualiserProcessor processor;
+            processor.prepareToPlay(sampleRate, blockSize);
+
+            const auto targets = getRuntimeParameters(processor);
+
+            std::atomic<bool> finished { false };
+            RealtimeChecks::reset();
+
+            std::thread audioThread([&]
+            {
+                juce::AudioBuffer<float> buffer(2, blockSize);
+                juce::MidiBuffer midi;
+                juce::Random noise(1);
+
+                RealtimeChecks::ScopedAudioThread scopedAudioThread;
+                for (auto block = 0; block < numBlocks; ++block)
+                {
+                    TestSignals::fillWithNoise(buffer, noise);
+                    processor.processBlock(buffer, midi);
+                }
+                finished = true;
+            });
+
+            // Host automation and UI changes arrive as parameter changes, sample accurate
+            // automation as events as well; both are thrown at the processor while it runs.
+            auto& random = getRandom();
+            auto numChanges = 0;
+            while (!finished)
+            {
+                auto* parameter = targets[random.nextInt(targets.size())];
+                const auto value = random.nextFloat();
+                parameter->setValueNotifyingHost(value);
+
+                if (random.nextBool())
+                    processor.addParameterEvent(parameter->getParameterIndex(), value, random.nextInt(blockSize));
+
+                if (++numChanges % 64 == 0)
+                    std::this_thread::yield();
+            }
+            audioThread.join();
+            processor.releaseResources();
+
+            logMessage(juce::String(numChanges) + " parameter changes over " + juce::String(numBlocks) + " blocks");
+            expectGreaterThan(numChanges, 0);
+            expectEquals(RealtimeChecks::getNumLocks(), juce::int64(0), "the audio thread locked a mutex");
+        }
+
+        beginTest("PartitionedConvolver never locks on the audio thread while its tail thread renders");
+        {
+            constexpr int impulseLength = 16384;
+            constexpr int numBlocks = 4000;
+
+            // Long enough for the tail, which is handed to the background thread block by block.
+            std::vector<float> impulse(impulseLength);
+            juce::Random random(2);
+            for (auto& tap : impulse)
+                tap = 0.1f * (2.0f * random.nextFloat() - 1.0f);
+
+            PartitionedConvolver convolver;
+            convolver.prepare({ sampleRate, juce::uint32(blockSize), 2 }, impulse.size());
+            convolver.loadImpulseResponse(impulse.data(), impulse.size());
+
+            juce::AudioBuffer<float> buffer(2, blockSize);
+            juce::Random noise(1);
+
+            RealtimeChecks::reset();
+            {
+                RealtimeChecks::ScopedAudioThread audioThread;
+                for (auto block = 0; block < numBlocks; ++block)
+                {
+                    TestSignals::fillWithNoise(buffer, noise);
+                    juce::dsp::AudioBlock<float> audioBlock(buffer);
+                    convolver.process(juce::dsp::ProcessContextReplacing<float>(audioBlock));
+                }
+            }
+
+            expectEquals(RealtimeChecks::getNumLocks(), juce::int64(0), "PartitionedConvolver::process() locked a mutex");
+        }
+    }
+
+    void runAllocationTests()
+    {
+        beginTest("Allocating on an audio thread is counted");
+        {
+            RealtimeChecks::reset();
+            {
+                RealtimeChecks::ScopedAudioThread audioThread;
+                juce::MemoryBlock block(64);
+            }
+            expectGreaterThan(RealtimeChecks::getNumAllocations(), juce::int64(0));
+        }
+
+        beginTest("10000 parameter changes allocate nothing on the audio or the design thread");
+        {
+            constexpr int numChanges = 10000;
+            constexpr int changesPerBlock = 16;
+
+            ParametricEqualiserProcessor processor;
+            processor.prepareToPlay(sampleRate, blockSize);
+
+            // The designs run in runDesignPass() below instead, where they are counted too.
+            processor.stopDesignThread();
+
+            const auto targets = getRuntimeParameters(processor);
+
+            juce::AudioBuffer<float> buffer(2, blockSize);
+            juce::MidiBuffer midi;
+            juce::Random noise(1);
+            auto& random = getRandom();
+
+            // A plugin wrapper hands a host's change to the parameter and its listeners on the
+            // audio thread, which is how the value tree's atomics the processor pulls from get
+            // it; sample accurate automation comes in as an event for the next block.
+            auto change = [&](juce::AudioProcessorParameter& parameter, float value)
+            {
+                parameter.setValue(value);
+                parameter.sendValueChangedMessageToListeners(value);
+                processor.addParameterEvent(parameter.getParameterIndex(), value, random.nextInt(blockSize));
+            };
+
+            auto render = [&]
+            {
+                TestSignals::fillWithNoise(buffer, noise);
+                processor.processBlock(buffer, midi);
+                processor.runDesignPass();
+            };
+
+            // Changes every parameter once before counting, so that what is set up on first use
+            // (listener lists, the first block and design pass) is not counted. The snapshots
+            // are for the morph in the second half of the burst.
+            for (auto* parameter : targets)
+                change(*parameter, parameter->getValue());
+            render();
+            processor.storeSnapshot(0);
+            for (auto* parameter : targets)
+                change(*parameter, random.nextFloat());
+            render();
+            processor.storeSnapshot(1);
+
+            RealtimeChecks::reset();
+            for (auto morphing : { false, true })
+            {
+                // A morph designs the bands on the audio thread, from the snapshots and the morph parameter.
+                processor.setMorphSnapshots(morphing ? 0 : -1, morphing ? 1 : -1);
+
+                RealtimeChecks::ScopedAudioThread audioThread;
+                for (auto i = 0; i < numChanges / 2; ++i)
+                {
+                    change(*targets[random.nextInt(targets.size())], random.nextFloat());
+
+                    if ((i + 1) % changesPerBlock == 0)
+                        render();
+                }
+            }
+            processor.releaseResources();
+
+            expectEquals(RealtimeChecks::getNumAllocations(), juce::int64(0), "a parameter change allocated on the audio or the design thread");
+        }
+    }
+};
+
+static RealtimeTests realtimeTests;
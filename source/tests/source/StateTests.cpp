@@ -0,0 +1,149 @@
+#include <JuceHeader.h>
+
+namespace
+{
+    juce::RangedAudioParameter* findParameter(juce::AudioProcessor& processor, const juce::String& parameterID)
+    {
+        for (auto* parameter : processor.getParameters())
+            if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter); ranged != nullptr && ranged->paramID == parameterID)
+                return ranged;
+        return nullptr;
+    }
+
+    void randomiseParameters(juce::AudioProcessor& processor, juce::Random& random)
+    {
+        for (auto* parameter : processor.getParameters())
+            if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter); ranged != nullptr && !ParametricEqualiserProcessor::isLatencyParameter(ranged->paramID))
+                ranged->setValueNotifyingHost(random.nextFloat());
+    }
+
+    juce::MemoryBlock getState(juce::AudioProcessor& processor)
+    {
+        juce::MemoryBlock state;
+        processor.getStateInformation(state);
+        return state;
+    }
+
+    void setState(juce::AudioProcessor& processor, const juce::MemoryBlock& state)
+    {
+        processor.setStateInformation(state.getData(), int(state.getSize()));
+    }
+
+    /** Returns the IDs of the saved parameters of the given bands, and of the saved global ones if asked to. */
+    juce::StringArray getParameterIDs(size_t firstBand, size_t numBands, bool includeGlobals)
+    {
+        juce::StringArray parameterIDs;
+        for (auto band = firstBand; band < firstBand + numBands; ++band)
+        {
+            parameterIDs.add(ParametricEqualiserProcessor::getTypeParamName(band));
+            parameterIDs.add(ParametricEqualiserProcessor::getFrequencyParamName(band));
+            parameterIDs.add(ParametricEqualiserProcessor::getQualityParamName(band));
+            parameterIDs.add(ParametricEqualiserProcessor::getGainParamName(band));
+            parameterIDs.add(ParametricEqualiserProcessor::getActiveParamName(band));
+            parameterIDs.add(ParametricEqualiserProcessor::getDynamicParamName(band));
+            parameterIDs.add(ParametricEqualiserProcessor::getThresholdParamName(band));
+            parameterIDs.add(ParametricEqualiserProcessor::getRatioParamName(band));
+            parameterIDs.add(ParametricEqualiserProcessor::getAttackParamName(band));
+            parameterIDs.add(ParametricEqualiserProcessor::getReleaseParamName(band));
+            parameterIDs.add(ParametricEqualiserProcessor::getSidechainParamName(band));
+            parameterIDs.add(ParametricEqualiserProcessor::getRoutingParamName(band));
+        }
+        if (includeGlobals)
+        {
+            parameterIDs.add(ParametricEqualiserProcessor::paramOutput);
+            parameterIDs.add(ParametricEqualiserProcessor::paramDesign);
+            parameterIDs.add(ParametricEqualiserProcessor::paramMorph);
+            parameterIDs.add(ParametricEqualiserProcessor::paramAutoGain);
+        }
+        return parameterIDs;
+    }
+}
+
+class StateTests : public juce::UnitTest
+{
+public:
+    StateTests() : juce::UnitTest("State", "EvilAudio") {}
+
+    void runTest() override
+    {
+        auto& random = getRandom();
+
+        beginTest("A state restores every parameter and the editor size");
+        {
+            ParametricEqualiserProcessor source, restored;
+            randomiseParameters(source, random);
+            source.setSavedSize({ 1000, 600 });
+
+            setState(restored, getState(source));
+            expectParametersEqual(source, restored, getParameterIDs(0, source.getNumBands(), true));
+            expect(restored.getSavedSize() == juce::Point<int>(1000, 600));
+            expectEquals(int(restored.getLastStateNumBands()), int(source.getNumBands()));
+        }
+
+        beginTest("A state with more bands restores the bands both have");
+        {
+            ParametricEqualiserProcessor source(ParametricEqualiserProcessor::maxNumBands), restored;
+            randomiseParameters(source, random);
+            const auto state = getState(source);
+
+            expectEquals(int(ParametricEqualiserProcessor::getNumBandsFromState(state.getData(), int(state.getSize()))),
+                         int(ParametricEqualiserProcessor::maxNumBands));
+
+            setState(restored, state);
+            expectParametersEqual(source, restored, getParameterIDs(0, restored.getNumBands(), true));
+            expectEquals(int(restored.getLastStateNumBands()), int(ParametricEqualiserProcessor::maxNumBands));
+        }
+
+        beginTest("A state with fewer bands leaves the other bands alone");
+        {
+            ParametricEqualiserProcessor source, defaults(ParametricEqualiserProcessor::maxNumBands),
+                                         restored(ParametricEqualiserProcessor::maxNumBands);
+            randomiseParameters(source, random);
+
+            setState(restored, getState(source));
+            expectParametersEqual(source, restored, getParameterIDs(0, source.getNumBands(), true));
+            expectParametersEqual(defaults, restored,
+                                  getParameterIDs(source.getNumBands(), restored.getNumBands() - source.getNumBands(), false));
+            expectEquals(int(restored.getLastStateNumBands()), int(source.getNumBands()));
+        }
+
+        beginTest("An editor size out of range is not restored");
+        {
+            ParametricEqualiserProcessor source, restored;
+            const auto size = restored.getSavedSize();
+            source.setSavedSize({ 10, 100000 });
+
+            setState(restored, getState(source));
+            expect(restored.getSavedSize() == size);
+        }
+
+        beginTest("A truncated state is ignored");
+        {
+            ParametricEqualiserProcessor source, defaults, restored;
+            randomiseParameters(source, random);
+            const auto state = getState(source);
+
+            // Cut into the band records, so the header promises more than there is.
+            setState(restored, juce::MemoryBlock(state.getData(), state.getSize() / 2));
+            expectParametersEqual(defaults, restored, getParameterIDs(0, restored.getNumBands(), true));
+        }
+    }
+
+private:
+    void expectParametersEqual(juce::AudioProcessor& expected, juce::AudioProcessor& actual, const juce::StringArray& parameterIDs)
+    {
+        for (const auto& parameterID : parameterIDs)
+        {
+            auto* expectedParameter = findParameter(expected, parameterID);
+            auto* actualParameter = findParameter(actual, parameterID);
+            if (expectedParameter == nullptr || actualParameter == nullptr)
+            {
+                expect(false, "missing parameter " + parameterID);
+                continue;
+            }
+            expectWithinAbsoluteError(actualParameter->getValue(), expectedParameter->getValue(), 1.0e-4f, parameterID);
+        }
+    }
+};
+
+static StateTests stateTests;
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/** Signals the tests and the benchmarks feed the equaliser with. */
+namespace TestSignals
+{
+    /** Fills a buffer with noise, which keeps the equaliser from sleeping and the filters out of denormals. */
+    template <typename SampleType>
+    void fillWithNoise(juce::AudioBuffer<SampleType>& buffer, juce::Random& random)
+    {
+        for (auto channel = 0; channel < buffer.getNumChannels(); ++channel)
+        {
+            auto* samples = buffer.getWritePointer(channel);
+            for (auto i = 0; i < buffer.getNumSamples(); ++i)
+                samples[i] = SampleType(0.25) * (SampleType(2) * SampleType(random.nextFloat()) - SampleType(1));
+        }
+    }
+}